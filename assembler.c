@@ -0,0 +1,742 @@
+/*
+The assembling process of a file.
+It calls the first and second read methods, and then creates the output files.
+The command line (main.c), the server (serve.c) and the library (imasm.c) are built on top of it.
+*/
+
+/* ======== Includes ======== */
+#include "assembler.h"
+#include <string.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* ====== Data Structures ====== */
+/* The names of the phases in the statistics (see statsPhase) */
+const char *g_statsPhaseNames[STATS_PHASES_NUM] = { "read", "first", "second", "object", "externs", "entries", "binary", "cache" };
+
+/* ====== Base 4 Special Table ====== */
+
+/* The base 4 special digits of every byte (see initBase4Table) */
+char g_base4Table[BASE4_TABLE_SIZE][BASE4_BYTE_DIGITS];
+
+/* ====== Methods ====== */
+
+/* Prints an error or a warning with its line number (0 - the message isn't about a line), and passes it to */
+/* ctx->onMessage (a context without a log only passes it). The text may be 'buffer' or a malloc block, which is freed. */
+void printMessage(assemblyContext *ctx, messageKind kind, int lineNum, char *text, char *buffer)
+{
+	ctx->messagesNum++;
+	if (ctx->log)
+	{
+		fprintf(ctx->log, "%s", (kind == MESSAGE_ERROR) ? "[Error] " : "[Warning] ");
+		if (lineNum)
+		{
+			fprintf(ctx->log, "At line %d: ", lineNum);
+		}
+		fprintf(ctx->log, "%s\n", text ? text : buffer);
+	}
+
+	if (ctx->onMessage)
+	{
+		ctx->onMessage(ctx->messageData, kind, lineNum, text ? text : buffer);
+	}
+	if (text != buffer)
+	{
+		free(text);
+	}
+}
+
+/* Prints an error with the line number (0 - the error isn't about a line). */
+void printError(assemblyContext *ctx, int lineNum, const char *format, ...)
+{
+	char buffer[MESSAGE_BUFFER_SIZE], *text = buffer;
+	int length;
+	va_list args;
+
+	va_start(args, format);
+	length = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	/* A longer text is formatted again into a malloc block (if malloc fails, the text is cut) */
+	if (length >= (int)sizeof(buffer) && (text = (char *)malloc(length + 1)))
+	{
+		va_start(args, format);
+		vsnprintf(text, length + 1, format, args);
+		va_end(args);
+	}
+	printMessage(ctx, MESSAGE_ERROR, lineNum, text, buffer);
+}
+
+/* Prints a warning with the line number (like printError). */
+void printWarning(assemblyContext *ctx, int lineNum, const char *format, ...)
+{
+	char buffer[MESSAGE_BUFFER_SIZE], *text = buffer;
+	int length;
+	va_list args;
+
+	va_start(args, format);
+	length = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	if (length >= (int)sizeof(buffer) && (text = (char *)malloc(length + 1)))
+	{
+		va_start(args, format);
+		vsnprintf(text, length + 1, format, args);
+		va_end(args);
+	}
+	printMessage(ctx, MESSAGE_WARNING, lineNum, text, buffer);
+}
+
+/* Fills g_base4Table. Must be called once, before any file is assembled. */
+void initBase4Table()
+{
+	static const char digits[] = BASE4_DIGITS;
+	int i, j;
+
+	for (i = 0; i < BASE4_TABLE_SIZE; i++)
+	{
+		/* The most significant digit is first */
+		for (j = 0; j < BASE4_BYTE_DIGITS; j++)
+		{
+			g_base4Table[i][j] = digits[(i >> (2 * (BASE4_BYTE_DIGITS - 1 - j))) & 3];
+		}
+	}
+}
+
+/* Writes a memory word in base 4 special (MEMORY_WORD_DIGITS chars, without '\0') into buffer. */
+/* Returns a pointer to the char after the word. */
+char *encodeBase4Spcl(int num, char *buffer)
+{
+	/* The high 6 bits are the last 3 digits of their byte, the low 8 bits are a whole byte */
+	memcpy(buffer, &g_base4Table[(num >> BYTE_SIZE) & 0x3F][1], BASE4_BYTE_DIGITS - 1);
+	memcpy(buffer + BASE4_BYTE_DIGITS - 1, g_base4Table[num & 0xFF], BASE4_BYTE_DIGITS);
+
+	return buffer + MEMORY_WORD_DIGITS;
+}
+
+/* Returns the full name of a file from a given name and ending. The name is taken from the arena of the context. */
+/* A relative name is in ctx->workDir if it's set (see --serve), or in the current directory. */
+char *getFileName(assemblyContext *ctx, char *name, char *ending)
+{
+	char *dir = (ctx->workDir && name[0] != '/') ? ctx->workDir : NULL;
+	char *fileName = (char *)arenaAlloc(&ctx->arena, (dir ? strlen(dir) + 1 : 0) + strlen(name) + strlen(ending) + 1);
+
+	if (fileName)
+	{
+		sprintf(fileName, "%s%s%s%s", dir ? dir : "", dir ? "/" : "", name, ending);
+	}
+	return fileName;
+}
+
+/* Returns the name of the output files of a source file (without the ending): in ctx->outDir if it's set, */
+/* or next to the source file. The name is taken from the arena of the context (NULL if there isn't enough memory). */
+char *getOutputName(assemblyContext *ctx, char *name)
+{
+	char *baseName = strrchr(name, '/'), *outputName;
+
+	if (!ctx->outDir)
+	{
+		return name;
+	}
+
+	baseName = baseName ? baseName + 1 : name;
+	outputName = (char *)arenaAlloc(&ctx->arena, strlen(ctx->outDir) + strlen(baseName) + 2);
+	if (outputName)
+	{
+		sprintf(outputName, "%s/%s", ctx->outDir, baseName);
+	}
+	return outputName;
+}
+
+/* Returns the directory of the .include files of a source file (see ctx->includeDir): the directory of the */
+/* source file with its '/'. The directory is taken from the arena of the context (NULL if there isn't enough memory). */
+char *getIncludeDir(assemblyContext *ctx, char *name)
+{
+	char *fileName = getFileName(ctx, name, ""), *dirEnd = fileName ? strrchr(fileName, '/') : NULL;
+
+	if (fileName)
+	{
+		fileName[dirEnd ? dirEnd - fileName + 1 : 0] = '\0';
+	}
+	return fileName;
+}
+
+/* Opens a file from a given name and ending, and returns a pointer to it. */
+FILE *openFile(assemblyContext *ctx, char *name, char *ending, const char *mode)
+{
+	char *fileName = getFileName(ctx, name, ending);
+
+	return fileName ? fopen(fileName, mode) : NULL;
+}
+
+/* Creates an output file from a given name and ending (see getOutputName), and writes the parts into it one after the other. */
+/* Each part is written with a single write. */
+void writeOutputParts(assemblyContext *ctx, char *name, char *ending, outputBuffer *partsArr, int partsNum)
+{
+	char *outputName = getOutputName(ctx, name);
+	char *fileName = outputName ? getFileName(ctx, outputName, ending) : NULL;
+	size_t written;
+	ssize_t count = 0;
+	int fd, i;
+
+	for (i = 0; i < partsNum; i++)
+	{
+		if (partsArr[i].failed)
+		{
+			fileName = NULL;
+		}
+	}
+	if (!fileName)
+	{
+		printError(ctx, 0, "Not enough memory to create the file \"%s%s\".", name, ending);
+		return;
+	}
+
+	fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+	{
+		printError(ctx, 0, "Can't create the file \"%s\".", fileName);
+		return;
+	}
+
+	for (i = 0; i < partsNum && count >= 0; i++)
+	{
+		/* One write is enough, unless it was interrupted */
+		written = 0;
+		while (written < partsArr[i].size && (count = write(fd, partsArr[i].data + written, partsArr[i].size - written)) > 0)
+		{
+			written += count;
+		}
+		ctx->stats.bytesWritten += written;
+	}
+	if (count < 0)
+	{
+		printError(ctx, 0, "Failed to write the file \"%s\".", fileName);
+	}
+
+	close(fd);
+}
+
+/* Creates an output file from a given name and ending, and writes all of 'output' into it with a single write. */
+void writeOutputFile(assemblyContext *ctx, char *name, char *ending, outputBuffer *output)
+{
+	writeOutputParts(ctx, name, ending, output, 1);
+}
+
+/* Appends the lines of the words from firstWord to lastWord (not included) of memoryArr, like in the .ob file. */
+void appendObjectLines(memoryArena *arena, outputBuffer *output, int *memoryArr, int firstWord, int lastWord)
+{
+	int i;
+	char word[MEMORY_WORD_DIGITS];
+
+	for (i = firstWord; i < lastWord; i++)
+	{
+		appendOutputStr(arena, output, "\n");
+		appendOutputNum(arena, output, FIRST_ADDRESS + i);
+		appendOutputStr(arena, output, "\t\t");
+		appendOutput(arena, output, word, encodeBase4Spcl(memoryArr[i], word) - word);
+	}
+}
+
+/* Creates the .obj file, which contains the assembled lines in base 2 wird. */
+void createObjectFile(assemblyContext *ctx, char *name, int IC, int DC, int *memoryArr)
+{
+	outputBuffer output = { 0 };
+
+	/* Print IC and DC */
+	appendOutputStr(&ctx->arena, &output, "\t\t");
+	appendOutputNum(&ctx->arena, &output, IC);
+	appendOutputStr(&ctx->arena, &output, "  ");
+	appendOutputNum(&ctx->arena, &output, DC);
+
+	/* Print all of memoryArr */
+	appendObjectLines(&ctx->arena, &output, memoryArr, 0, IC + DC);
+
+	writeOutputFile(ctx, name, ".ob", &output);
+}
+
+/* Adds a line of a label and an address to an .ent/.ext output (the lines are separated by '\n'). */
+void addAddressLine(assemblyContext *ctx, outputBuffer *output, char *labelName, int address)
+{
+	if (output->size)
+	{
+		appendOutputStr(&ctx->arena, output, "\n");
+	}
+	appendOutputStr(&ctx->arena, output, labelName);
+	appendOutputStr(&ctx->arena, output, "\t\t");
+	appendOutputNum(&ctx->arena, output, address);
+}
+
+/* Creates the .ent file, which contains the addresses for the .entry labels. */
+void createEntriesFile(assemblyContext *ctx, char *name)
+{
+	int i;
+	outputBuffer output = { 0 };
+
+	for (i = 0; i < ctx->entryLabelsNum; i++)
+	{
+		labelInfo *label = &ctx->labelArr[ctx->entryArr[i].labelInd];
+
+		addAddressLine(ctx, &output, label->name, label->address);
+	}
+
+	/* Don't create the entries file if there aren't entry lines */
+	if (output.size || output.failed)
+	{
+		writeOutputFile(ctx, name, ".ent", &output);
+	}
+}
+
+/* Creates the .ext file, which contains the addresses for the extern labels operands (collected by the 2nd read). */
+void createExternFile(assemblyContext *ctx, char *name)
+{
+	int i;
+	outputBuffer output = { 0 };
+
+	for (i = 0; i < ctx->externNum; i++)
+	{
+		addAddressLine(ctx, &output, ctx->labelArr[ctx->externArr[i].labelInd].name, ctx->externArr[i].address);
+	}
+
+	/* Create the file only if there is at least 1 extern */
+	if (output.size || output.failed)
+	{
+		writeOutputFile(ctx, name, ".ext", &output);
+	}
+}
+
+/* Returns the offset of the name of a label in the strings of a binary file. Adds the name if it isn't there yet. */
+/* nameOffsets keeps the offset of each label in ctx->labelArr (-1 if it wasn't added). */
+long getNameOffset(assemblyContext *ctx, outputBuffer *strings, long *nameOffsets, labelInfo *label)
+{
+	long *offset = &nameOffsets[label - ctx->labelArr];
+
+	if (*offset < 0)
+	{
+		*offset = strings->size;
+		appendOutput(&ctx->arena, strings, label->name, strlen(label->name) + 1);
+	}
+	return *offset;
+}
+
+/* Creates the .bin file, which contains everything in the .ob, .ent and .ext files, in a binary format a loader can map. */
+/* All the numbers are unsigned, little endian. The file has: */
+/*	- A header of BIN_HEADER_FIELDS 32 bit fields: BIN_MAGIC, BIN_VERSION, the base address, IC, DC, the words offset, */
+/*	  the number and offset of the entries, externs and relocations, and the size and offset of the strings. */
+/*	- The IC + DC memory words, 16 bits each (14 bits used), padded to 4 bytes. */
+/*	- The entries and externs: a 32 bit name offset (in the strings) and a 32 bit address each. */
+/*	- The relocations: the 32 bit addresses of the words which contain a label address (RELOCATABLE words). */
+/*	- The strings: the label names, each ends with '\0'. */
+void createBinaryFile(assemblyContext *ctx, char *name, int IC, int DC, int *memoryArr)
+{
+	outputBuffer output = { 0 }, strings = { 0 };
+	long *nameOffsets = (long *)arenaAlloc(&ctx->arena, (ctx->labelNum + 1) * sizeof(long));
+	long wordsOffset = BIN_HEADER_FIELDS * 4, entriesOffset, externsOffset, relocsOffset, stringsOffset;
+	int i, relocsNum = 0;
+
+	if (!nameOffsets)
+	{
+		printError(ctx, 0, "Not enough memory to create the file \"%s.bin\".", name);
+		return;
+	}
+	for (i = 0; i < ctx->labelNum; i++)
+	{
+		nameOffsets[i] = -1;
+	}
+
+	/* Add the names to the strings first, so their size is known (the tables get the same offsets later) */
+	for (i = 0; i < ctx->entryLabelsNum; i++)
+	{
+		getNameOffset(ctx, &strings, nameOffsets, &ctx->labelArr[ctx->entryArr[i].labelInd]);
+	}
+	for (i = 0; i < ctx->externNum; i++)
+	{
+		getNameOffset(ctx, &strings, nameOffsets, &ctx->labelArr[ctx->externArr[i].labelInd]);
+	}
+
+	/* The label operands are the relocatable command words */
+	for (i = 0; i < IC; i++)
+	{
+		if ((memoryArr[i] & 3) == RELOCATABLE)
+		{
+			relocsNum++;
+		}
+	}
+
+	entriesOffset = wordsOffset + ((IC + DC) * 2 + 3) / 4 * 4;
+	externsOffset = entriesOffset + ctx->entryLabelsNum * 8;
+	relocsOffset = externsOffset + ctx->externNum * 8;
+	stringsOffset = relocsOffset + relocsNum * 4;
+
+	/* Header */
+	appendOutput(&ctx->arena, &output, BIN_MAGIC, 4);
+	appendOutputUint(&ctx->arena, &output, BIN_VERSION, 4);
+	appendOutputUint(&ctx->arena, &output, FIRST_ADDRESS, 4);
+	appendOutputUint(&ctx->arena, &output, IC, 4);
+	appendOutputUint(&ctx->arena, &output, DC, 4);
+	appendOutputUint(&ctx->arena, &output, wordsOffset, 4);
+	appendOutputUint(&ctx->arena, &output, ctx->entryLabelsNum, 4);
+	appendOutputUint(&ctx->arena, &output, entriesOffset, 4);
+	appendOutputUint(&ctx->arena, &output, ctx->externNum, 4);
+	appendOutputUint(&ctx->arena, &output, externsOffset, 4);
+	appendOutputUint(&ctx->arena, &output, relocsNum, 4);
+	appendOutputUint(&ctx->arena, &output, relocsOffset, 4);
+	appendOutputUint(&ctx->arena, &output, strings.size, 4);
+	appendOutputUint(&ctx->arena, &output, stringsOffset, 4);
+
+	/* Words */
+	for (i = 0; i < IC + DC; i++)
+	{
+		appendOutputUint(&ctx->arena, &output, memoryArr[i] & 0x3FFF, 2);
+	}
+	appendOutputUint(&ctx->arena, &output, 0, entriesOffset - wordsOffset - (IC + DC) * 2);
+
+	/* Entries */
+	for (i = 0; i < ctx->entryLabelsNum; i++)
+	{
+		labelInfo *label = &ctx->labelArr[ctx->entryArr[i].labelInd];
+
+		appendOutputUint(&ctx->arena, &output, getNameOffset(ctx, &strings, nameOffsets, label), 4);
+		appendOutputUint(&ctx->arena, &output, label->address, 4);
+	}
+
+	/* Externs */
+	for (i = 0; i < ctx->externNum; i++)
+	{
+		appendOutputUint(&ctx->arena, &output, getNameOffset(ctx, &strings, nameOffsets, &ctx->labelArr[ctx->externArr[i].labelInd]), 4);
+		appendOutputUint(&ctx->arena, &output, ctx->externArr[i].address, 4);
+	}
+
+	/* Relocations */
+	for (i = 0; i < IC; i++)
+	{
+		if ((memoryArr[i] & 3) == RELOCATABLE)
+		{
+			appendOutputUint(&ctx->arena, &output, FIRST_ADDRESS + i, 4);
+		}
+	}
+
+	/* Strings */
+	appendOutput(&ctx->arena, &output, strings.data, strings.size);
+	output.failed |= strings.failed;
+
+	writeOutputFile(ctx, name, ".bin", &output);
+}
+
+/* ====== Statistics ====== */
+
+/* Returns the time in seconds of a monotonic clock. */
+double getWallTime()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* Adds the time since 'start' to the phase, and starts the next phase. Does nothing without --stats. */
+void endStatsPhase(assemblyContext *ctx, statsPhase phase, double *start)
+{
+	double now;
+
+	if (ctx->options.stats)
+	{
+		now = getWallTime();
+		ctx->stats.seconds[phase] += now - *start;
+		*start = now;
+	}
+}
+
+/* Adds 'stats' to 'total'. */
+void addStats(assemblyStats *total, assemblyStats *stats)
+{
+	int i;
+
+	for (i = 0; i < STATS_PHASES_NUM; i++)
+	{
+		total->seconds[i] += stats->seconds[i];
+	}
+	total->filesNum += stats->filesNum;
+	total->failedNum += stats->failedNum;
+	total->linesNum += stats->linesNum;
+	total->wordsNum += stats->wordsNum;
+	total->lookupsNum += stats->lookupsNum;
+	total->allocsNum += stats->allocsNum;
+	total->blocksNum += stats->blocksNum;
+	total->bytesWritten += stats->bytesWritten;
+}
+
+/* Prints the statistics in one "key=value" line, so scripts can parse them. */
+/* The times are in seconds. wallTime is printed only if it's positive (the time of all the files). */
+void printStats(FILE *out, char *name, assemblyStats *stats, double wallTime)
+{
+	int i;
+	double seconds = 0;
+
+	fprintf(out, "[Stats] file=%s files=%ld failed=%ld lines=%ld words=%ld lookups=%ld allocs=%ld blocks=%ld bytes=%ld",
+		name, stats->filesNum, stats->failedNum, stats->linesNum, stats->wordsNum, stats->lookupsNum, stats->allocsNum, stats->blocksNum, stats->bytesWritten);
+	for (i = 0; i < STATS_PHASES_NUM; i++)
+	{
+		fprintf(out, " %s=%.6f", g_statsPhaseNames[i], stats->seconds[i]);
+		seconds += stats->seconds[i];
+	}
+	fprintf(out, " seconds=%.6f", seconds);
+	if (wallTime > 0)
+	{
+		fprintf(out, " wall=%.6f", wallTime);
+	}
+	fprintf(out, "\n");
+}
+
+/* ====== Context ====== */
+
+/* Returns a new empty assembly context, which prints its messages to stdout (or NULL if malloc failed). */
+assemblyContext *createContext()
+{
+	assemblyContext *ctx = (assemblyContext *)calloc(1, sizeof(assemblyContext));
+
+	if (ctx)
+	{
+		ctx->log = stdout;
+		ctx->options.maxWords = MAX_DATA_NUM;
+		ctx->options.format = FORMAT_TEXT;
+	}
+	return ctx;
+}
+
+/* Frees the context and all its malloc blocks. */
+void freeContext(assemblyContext *ctx)
+{
+	free(ctx->labelArr);
+	free(ctx->macroArr);
+	free(ctx->entryArr);
+	free(ctx->dataArr);
+	free(ctx->instrArr);
+	free(ctx->codeArr);
+	free(ctx->fixupArr);
+	free(ctx->externArr);
+	free(ctx->lookupArr);
+	free(ctx->cache.linesArr);
+	freeHashIndex(&ctx->cache.index);
+	freeHashIndex(&ctx->labelIndex);
+	freeHashIndex(&ctx->entryIndex);
+	freeHashIndex(&ctx->macroIndex);
+	freeStream(ctx);
+	freeParallelRead(ctx);
+	arenaFree(&ctx->arena);
+	free(ctx);
+}
+
+/* Resets the context and releases the memory of the file. */
+/* The arrays are only counted out (their items are always written before they are read), so a reset doesn't */
+/* depend on the size of the last file, and a context can be reused for many small files (see --batch). */
+void clearData(assemblyContext *ctx)
+{
+	/* --- Reset Context --- */
+
+	/* Reset the labels, macros and entries (the data is counted by DC) */
+	ctx->labelNum = 0;
+	clearHashIndex(&ctx->labelIndex);
+	ctx->macroNum = 0;
+	clearHashIndex(&ctx->macroIndex);
+	ctx->entryLabelsNum = 0;
+	clearHashIndex(&ctx->entryIndex);
+
+	/* Reset the instructions and the single pass arrays */
+	ctx->instrNum = 0;
+	ctx->codeNum = 0;
+	ctx->fixupNum = 0;
+	ctx->externNum = 0;
+
+	/* Reset the lookups and the chunks of the parallel read */
+	ctx->lookupNum = 0;
+	ctx->lookupsFailed = FALSE;
+	clearParallelRead(ctx);
+
+	/* Reset the line cache */
+	ctx->cache.linesNum = 0;
+	ctx->cache.macroHash = 0;
+	ctx->cache.usedNum = 0;
+	ctx->cache.isChanged = FALSE;
+	clearHashIndex(&ctx->cache.index);
+	ctx->messagesNum = 0;
+	memset(&ctx->stats, 0, sizeof(assemblyStats));
+
+	/* Release the source, the lines and all the other memory of the file at once */
+	freeStream(ctx);
+	arenaReset(&ctx->arena);
+	ctx->source = NULL;
+	ctx->includeDir = NULL;
+	ctx->scan.start = NULL;
+}
+
+/* Encodes the memory image of a file after its first read: the second read (or only the fixups in single pass mode; */
+/* with --threads, ranges of the instructions are encoded at the same time). Adds the errors to numOfErrors. */
+/* Returns the IC + DC words of the image (in the arena), or NULL if there isn't enough memory. */
+int *encodeMemoryImage(assemblyContext *ctx, linesList *lines, int IC, int DC, int *numOfErrors)
+{
+	/* The memory image needs IC + DC words at most */
+	int *memoryArr = (int *)arenaAlloc(&ctx->arena, (IC + DC + 1) * sizeof(int));
+
+	if (!memoryArr)
+	{
+		return NULL;
+	}
+	memset(memoryArr, 0, (IC + DC + 1) * sizeof(int));
+
+	if (ctx->options.singlePass)
+	{
+		*numOfErrors += finishSinglePass(ctx, memoryArr, IC, DC);
+	}
+	else
+	{
+		*numOfErrors += parallelSecondRead(ctx, memoryArr, lines, IC, DC);
+	}
+	return memoryArr;
+}
+
+/* Parsing a file, and creating the output files. */
+void parseFile(assemblyContext *ctx, char *fileName)
+{
+	FILE *file = openFile(ctx, fileName, ".as", "r");
+
+	/* Open File */
+	if (file == NULL)
+	{
+		fprintf(ctx->log, "[Info] Can't open the file \"%s.as\".\n", fileName);
+		arenaReset(&ctx->arena);
+		return;
+	}
+	fprintf(ctx->log, "[Info] Successfully opened the file \"%s.as\".\n", fileName);
+
+	assembleFile(ctx, fileName, file);
+}
+
+/* Assembles the source in 'file' (it's closed when it's read), and creates the output files of 'fileName'. */
+/* The source may also come from memory (see --serve). */
+void assembleFile(assemblyContext *ctx, char *fileName, FILE *file)
+{
+	linesList lines = { 0 };
+	int *memoryArr, IC = 0, DC = 0, numOfErrors = 0;
+	size_t sourceSize;
+	long allocsNum = ctx->arena.allocsNum, blocksNum = ctx->arena.blocksNum;
+	double start = ctx->options.stats ? getWallTime() : 0;
+
+	/* The files it includes are next to it */
+	ctx->includeDir = getIncludeDir(ctx, fileName);
+
+	if (ctx->options.stream)
+	{
+		/* Read, parse and encode the file at the same time */
+		numOfErrors += streamFileRead(ctx, file, &IC, &DC);
+		fclose(file);
+		endStatsPhase(ctx, STATS_FIRST, &start);
+	}
+	else
+	{
+		/* Read the whole file at once */
+		ctx->source = readSourceFile(&ctx->arena, file, &sourceSize);
+		fclose(file);
+		if (!ctx->source)
+		{
+			printError(ctx, 0, "Not enough memory to read the file \"%s.as\".", fileName);
+			clearData(ctx);
+			return;
+		}
+
+		endStatsPhase(ctx, STATS_READ, &start);
+
+		/* Load the lines of the last assembly */
+		if (ctx->options.useCache)
+		{
+			loadLineCache(ctx, fileName);
+			endStatsPhase(ctx, STATS_CACHE, &start);
+		}
+
+		/* First Read (with --threads, the chunks of the file are read at the same time) */
+		numOfErrors += parallelFileRead(ctx, ctx->source, sourceSize, &lines, &IC, &DC);
+		endStatsPhase(ctx, STATS_FIRST, &start);
+	}
+
+	/* Second Read */
+	memoryArr = encodeMemoryImage(ctx, &lines, IC, DC, &numOfErrors);
+	if (!memoryArr)
+	{
+		printError(ctx, 0, "Not enough memory to assemble the file \"%s.as\".", fileName);
+		clearData(ctx);
+		return;
+	}
+	endStatsPhase(ctx, STATS_SECOND, &start);
+
+	/* Create Output Files */
+	if (numOfErrors == 0)
+	{
+		/* Create all the output files */
+		if (ctx->options.format & FORMAT_TEXT)
+		{
+			if (ctx->options.stream)
+			{
+				writeStreamObjectFile(ctx, fileName, IC, DC, memoryArr);
+			}
+			else
+			{
+				createObjectFile(ctx, fileName, IC, DC, memoryArr);
+			}
+			endStatsPhase(ctx, STATS_OBJECT, &start);
+			createExternFile(ctx, fileName);
+			endStatsPhase(ctx, STATS_EXTERN, &start);
+			createEntriesFile(ctx, fileName);
+			endStatsPhase(ctx, STATS_ENTRIES, &start);
+		}
+		if (ctx->options.format & FORMAT_BIN)
+		{
+			createBinaryFile(ctx, fileName, IC, DC, memoryArr);
+			endStatsPhase(ctx, STATS_BINARY, &start);
+		}
+		fprintf(ctx->log, "[Info] Created output files for the file \"%s.as\".\n", fileName);
+	}
+	else
+	{
+		/* print the number of errors. */
+		fprintf(ctx->log, "[Info] A total of %d error%s found throughout \"%s.as\".\n", numOfErrors, (numOfErrors > 1) ? "s were" : " was", fileName);
+	}
+
+	/* Keep the lines for the next assembly */
+	if (ctx->options.useCache)
+	{
+		saveLineCache(ctx, fileName);
+		endStatsPhase(ctx, STATS_CACHE, &start);
+	}
+
+	/* Print the statistics of the file, and add them to the total */
+	ctx->stats.filesNum = 1;
+	ctx->stats.failedNum = numOfErrors ? 1 : 0;
+	ctx->stats.wordsNum = IC + DC;
+	ctx->stats.allocsNum = ctx->arena.allocsNum - allocsNum;
+	ctx->stats.blocksNum = ctx->arena.blocksNum - blocksNum;
+	if (ctx->options.stats)
+	{
+		printStats(ctx->log, fileName, &ctx->stats, 0);
+	}
+	addStats(&ctx->totalStats, &ctx->stats);
+
+	/* Free all malloc pointers, and reset the context. */
+	clearData(ctx);
+}
+
+/* Copies the messages in 'log' to 'out' and closes it. */
+void printLog(FILE *log, FILE *out)
+{
+	char buf[BUFSIZ];
+	size_t length;
+
+	rewind(log);
+	while ((length = fread(buf, 1, sizeof(buf), log)) > 0)
+	{
+		fwrite(buf, 1, length, out);
+	}
+	fclose(log);
+}
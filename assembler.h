@@ -1,173 +1,603 @@
-/*
-General header file for the assembly.
-Contains macros, data structures and methods declaration.
-*/
-
-#ifndef ASSEMBLER_H
-#define ASSEMBLER_H
-
-#include <stdio.h>
-#include <string.h>
-
-/* ========== Macros ========== */
-/* Utilities */
-#define FOREVER				for(;;)
-#define BYTE_SIZE			8
-#define FALSE				0
-#define TRUE				1
-
-/* Given Constants */
-#define MAX_DATA_NUM		4096
-#define FIRST_ADDRESS		100 
-#define MAX_LINE_LENGTH		80
-#define MAX_LABEL_LENGTH	30
-#define MEMORY_WORD_LENGTH	14
-#define MAX_REGISTER_DIGIT	7
-#define MACRO_COMMAND		"define"
-/* Defining Constants */
-#define MAX_LINES_NUM		700
-#define MAX_LABELS_NUM		MAX_LINES_NUM 
-
-/* ========== Data Structures ========== */
-typedef unsigned int bool; /* Only get TRUE or FALSE values */
-
-/* === First Read  related === */
-
-/* Labels Management */
-typedef struct
-{
-	int address;					/* The address it contains */
-	char name[MAX_LABEL_LENGTH];	/* The name of the label */
-	bool isExtern;					/* Extern flag */
-	bool isData;					/* Data flag (.data or .string) */
-} labelInfo;
-
-/* Directive, Macro And Commands */
-typedef struct
-{
-	char *name;
-	void(*parseFunc)();
-} directive;
-
-typedef struct
-{
-	char name[MAX_LABEL_LENGTH];
-	int lineNum;
-	int value;
-
-} macro;
-
-typedef struct
-{
-	char *name;
-	unsigned int opcode : 4;
-	int numOfParams;
-} command;
-
-/* Operands */
-typedef enum { NUMBER = 0, LABEL = 1, INDEX = 2,REGISTER = 3, INVALID = -1 } opType; /* Addressing methods of the operands as described*/
-
-typedef struct
-{
-	int indexVal;			/* Index value in case of Index opType */
-	int value;				/* Value */
-	char *str;				/* String */
-	opType type;			/* Type of operands */
-	int address;			/* The address of the operand in the memory */
-} operandInfo;
-
-/* Line */
-typedef struct
-{
-	int lineNum;				/* The number of the line in the file */
-	int address;				/* The address of the first word in the line */
-	char *originalString;		/* The original pointer, allocated by malloc */
-	char *lineStr;				/* The text it contains (changed while using parseLine) */
-	bool isError;				/* Represent whether there is an error or not*/
-	labelInfo *label;			/* A poniter to the lines label in labelArr */
-	char *commandStr;			/* The string of the command or directive */
-	macro *mac;					/* A pointer to macro in macroArr */
-	char *tempStr;				/* Temporary text of the line (use to adjust parsing in some cases */
-	/* Command line */
-	const command *cmd;			/* A pointer to the command in g_cmdArr */
-	operandInfo op1;			/* The 1st operand */
-	operandInfo op2;			/* The 2nd operand */
-	labelInfo *jumpLabel;		/* A poniter to the lines label in labelArr */
-	char jumpLabelName[MAX_LABEL_LENGTH]; /* the name of label in labelArr */
-} lineInfo;
-
-/* === Second Read  === */
-
-typedef enum { ABSOLUTE = 0, EXTENAL = 1, RELOCATABLE = 2 } eraType;
-
-/* Memory Word */
-
-typedef struct /* 14 bits */
-{
-	unsigned int era : 2;
-
-	union /* 12 bits */
-	{
-		/* Commands (only 12 bits) */
-		struct
-		{
-			unsigned int dest : 2;		/* Destination op addressing method ID */
-			unsigned int src : 2;		/* Source op addressing method ID */
-			unsigned int opcode : 4;	/* Command ID */
-			unsigned int unUsed : 4;  	/* Bits have no use */
-		} cmdBits;	/*Refering to the first 'word' in the translation */
-
-		/* Registers (only 12 bits) */
-		struct
-		{
-			unsigned int destBits : 3;
-			unsigned int srcBits : 3;
-		} regBits;
-
-		/* Other operands */
-		int value : 12; /* (12 bits) */
-
-	} valueBits; /* End of 12 bits union */
-
-} memoryWord;
-
-
-/* ======== Methods Declaration ======== */
-
-/* utility.c methods */
-int getCmdId(char *cmdName);
-labelInfo *getLabel(char *labelName);
-void trimLeftStr(char **ptStr);
-void trimStr(char **ptStr);
-char *getFirstTok(char *str, char **endOfTok);
-bool isOneWord(char *str);
-bool isWhiteSpaces(char *str);
-bool isLegalLabel(char *label, int lineNum, bool printErrors);
-bool isExistingLabel(char *label);
-bool isExistingEntryLabel(char *labelName);
-bool isRegister(char *str, int *value);
-bool isCommentOrEmpty(lineInfo *line);
-char *getFirstOperand(char *line, char **endOfOp, bool *foundComma);
-bool isDirective(char *cmd);
-bool isMacro(char *cmd);
-bool isLegalStringParam(char **strParam, int lineNum);
-int getCmdOpCode(char *cmdName);
-bool isLegalNum(char *numStr, int numOfBits, int lineNum, int *value);
-macro *getMacro(char *macroName);
-bool isExistingMacro(char *macro);
-int *getMacroValue(macro *mac,int *val);
-int getIndexValue(operandInfo *operand);
-int getAddressValue(operandInfo *operand);
-
-/* firstRead.c methods */
-int firstFileRead(FILE *file, lineInfo *linesArr, int *linesFound, int *IC, int *DC);
-void findMacroName(lineInfo *line);
-bool areLegalOpTypes(const command *cmd, operandInfo op1, operandInfo op2, int lineNum);
-bool addNumberToData(int num, int *IC, int *DC, int lineNum);
-/* secondRead.c methods */
-int secondFileRead(int *memoryArr, lineInfo *linesArr, int lineNum, int IC, int DC);
-
-/* main.c methods */
-void printError(int lineNum, const char *format, ...);
-
-#endif
+/*
+General header file for the assembly.
+Contains macros, data structures and methods declaration.
+*/
+
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <stdio.h>
+#include <string.h>
+
+/* ========== Macros ========== */
+/* Utilities */
+#define FOREVER				for(;;)
+#define BYTE_SIZE			8
+#define FALSE				0
+#define TRUE				1
+
+/* Given Constants */
+#define MAX_DATA_NUM		4096
+#define FIRST_ADDRESS		100 
+#define MAX_LINE_LENGTH		80
+#define MAX_LABEL_LENGTH	30
+#define MEMORY_WORD_LENGTH	14
+#define MAX_LINE_WORDS		5		/* The most memory words of a command line (command, 2 operands and 2 indexes) */
+#define MEMORY_WORD_DIGITS	7		/* The length of a memory word in base 4 special */
+#define BASE4_DIGITS		"*#%!"	/* The base 4 special digits, from 0 to 3 */
+#define BASE4_BYTE_DIGITS	4		/* The number of base 4 digits in a byte */
+#define BASE4_TABLE_SIZE	256
+#define MAX_REGISTER_DIGIT	7
+#define MACRO_COMMAND		"define"
+/* Defining Constants */
+#define FIRST_ARRAY_SIZE	256		/* The first size of the growing arrays */
+#define LINES_CHUNK_SIZE	256		/* The number of lines in each chunk of a linesList */
+#define BIN_MAGIC			"IMOB"	/* The first bytes of a binary object file (see createBinaryFile) */
+#define BIN_VERSION			1
+#define BIN_HEADER_FIELDS	14		/* The number of 32 bit fields in the header of a binary object file */
+#define MIN_HASH_SIZE		64	/* First number of slots in a hash index (must be a power of 2) */
+#define HASH_SHRINK_RATIO	16	/* A cleared hash index with this many slots per item is freed (see clearHashIndex) */
+#define ARENA_BLOCK_SIZE	65536	/* The size of a memory arena block (bigger allocations get their own block) */
+#define SCAN_BLOCK_SIZE		16		/* The number of chars classified at once by the line scanner (see lineScan.c) */
+#define STREAM_CHUNK_SIZE	65536	/* The first size of a chunk of lines in stream mode (see stream.c) */
+#define STREAM_RING_SIZE	8		/* The number of items in a ring between two stages of the stream mode */
+#define STREAM_BATCH_SIZE	256		/* The number of instructions in a batch of the stream mode encoder */
+#define MIN_CHUNK_LINES		4096	/* The fewest lines in a chunk of the parallel first read (see parallelRead.c) */
+#define MIN_RANGE_INSTRS	4096	/* The fewest instructions in a range of the parallel second read */
+#define SERVE_QUEUE_SIZE	64		/* The connections which wait for a worker of the server (see serve.c) */
+#define SERVE_JOBS_NUM		4		/* The number of workers of the server without -j */
+#define INCLUDE_SLOTS_NUM	64		/* The number of slots of the cache of the included files (must be a power of 2) */
+#define INCLUDE_CACHE_SIZE	256		/* The most modules in the cache of the included files (see include.c) */
+#define MESSAGE_BUFFER_SIZE	256		/* The text of a message which is longer gets a malloc block (see printError) */
+#define SCAN_BLOCKS_NUM		((MAX_LINE_LENGTH + SCAN_BLOCK_SIZE - 1) / SCAN_BLOCK_SIZE)
+/* Chars Classes (see g_charClass) */
+#define CHAR_SPACE			1		/* A white space (like isspace in the "C" locale) */
+#define CHAR_BREAK			2		/* A white space, a separator (, : = [ ] ") or '\0' */
+#define IS_SPACE_CHAR(c)	(g_charClass[(unsigned char)(c)] & CHAR_SPACE)
+#define IS_BREAK_CHAR(c)	(g_charClass[(unsigned char)(c)] & CHAR_BREAK)
+
+/* ========== Data Structures ========== */
+typedef unsigned int bool; /* Only get TRUE or FALSE values */
+
+/* === First Read  related === */
+
+/* Labels Management */
+typedef struct
+{
+	int address;					/* The address it contains */
+	char name[MAX_LABEL_LENGTH];	/* The name of the label */
+	bool isExtern;					/* Extern flag */
+	bool isData;					/* Data flag (.data or .string) */
+} labelInfo;
+
+/* An .entry label (see parseEntryDirc) */
+typedef struct
+{
+	char *name;						/* The name, in the source */
+	int lineNum;					/* The line of the .entry directive */
+	int labelInd;					/* The index of the label in labelArr (see countIllegalEntries) */
+} entryLabel;
+
+/* Directive, Macro And Commands */
+typedef struct
+{
+	char *name;
+	void(*parseFunc)();
+} directive;
+
+typedef struct
+{
+	char name[MAX_LABEL_LENGTH];
+	int lineNum;
+	int value;
+
+} macro;
+
+typedef struct
+{
+	char *name;
+	unsigned int opcode : 4;
+	int numOfParams;
+} command;
+
+/* Reserved Words (see reservedWords.def) */
+typedef enum { RESERVED_NONE = 0, RESERVED_COMMAND, RESERVED_DIRECTIVE, RESERVED_REGISTER, RESERVED_MACRO } reservedKind;
+
+typedef struct
+{
+	const char *name;
+	reservedKind kind;
+	int id;							/* Opcode, index in g_dircArr or register number */
+} reservedWord;
+
+/* One step of the reserved words hash (genReserved.c finds a multiplier which makes it perfect) */
+#define RESERVED_HASH_STEP(hash, c, mult)	(((hash) ^ (unsigned char)(c)) * (mult))
+
+/* Symbols Hashing */
+typedef struct
+{
+	unsigned int hash;				/* The hash of the name (0 represent an empty slot) */
+	int index;						/* The index of the symbol in its array */
+} hashSlot;
+
+typedef struct
+{
+	hashSlot *slots;				/* Open addressing (linear probing) slots, allocated by malloc */
+	unsigned int size;				/* The number of slots (always a power of 2) */
+	int count;						/* The number of used slots */
+} hashIndex;
+
+/* Operands */
+typedef enum { NUMBER = 0, LABEL = 1, INDEX = 2,REGISTER = 3, INVALID = -1 } opType; /* Addressing methods of the operands as described*/
+
+typedef struct
+{
+	int indexVal;			/* Index value in case of Index opType */
+	int value;				/* Value */
+	char *str;				/* String */
+	opType type;			/* Type of operands */
+	int address;			/* The address of the operand in the memory */
+} operandInfo;
+
+/* Line */
+typedef struct
+{
+	int lineNum;				/* The number of the line in the file */
+	int address;				/* The address of the first word in the line */
+	char *originalString;		/* The start of the line in the source buffer (see readSourceFile) */
+	char *lineStr;				/* The text it contains (changed while using parseLine) */
+	bool isError;				/* Represent whether there is an error or not*/
+	labelInfo *label;			/* A poniter to the lines label in labelArr */
+	char *commandStr;			/* The string of the command or directive */
+	macro *mac;					/* A pointer to macro in macroArr */
+	char *tempStr;				/* Temporary text of the line (use to adjust parsing in some cases */
+	/* Command line */
+	const command *cmd;			/* A pointer to the command in g_cmdArr */
+	operandInfo op1;			/* The 1st operand */
+	operandInfo op2;			/* The 2nd operand */
+} lineInfo;
+
+/* Lines List */
+typedef struct
+{
+	lineInfo **chunksArr;			/* The chunks of the lines (in the arena) */
+	int chunksArrSize;
+	int linesNum;					/* The number of lines in the list */
+	int lineNumOffset;				/* The number of lines in the file before the list (see parallelFileRead) */
+} linesList;
+
+/* === Second Read  === */
+
+/* An operand of an instruction */
+typedef struct
+{
+	int value;					/* The number or register, or the address of the label (see updateLableOpAddress) */
+	int indexVal;				/* The index of an INDEX operand */
+	int labelInd;				/* The symbol id of a label operand (its index in labelArr), or -1 before it's resolved */
+	signed char type;			/* opType (INVALID if the command doesn't have this operand) */
+	unsigned char isExtern;		/* TRUE if it's a LABEL operand of an extern label */
+} instrOperand;
+
+/* A command line without errors, with only what encoding it needs (see addInstruction). */
+/* The instructions are kept in one array, so the second read doesn't go over the fat lineInfo records. */
+/* The text of the line and the names of its labels stay in the line (in the lines list, at lineInd). */
+typedef struct
+{
+	int lineInd;				/* The index of the line in the lines list */
+	int wordInd;				/* The index of the command word in the memory */
+	unsigned char opcode;
+	instrOperand op1;			/* The source operand */
+	instrOperand op2;			/* The destination operand */
+} instruction;
+
+typedef enum { ABSOLUTE = 0, EXTENAL = 1, RELOCATABLE = 2 } eraType;
+
+/* Memory Word */
+
+typedef struct /* 14 bits */
+{
+	unsigned int era : 2;
+
+	union /* 12 bits */
+	{
+		/* Commands (only 12 bits) */
+		struct
+		{
+			unsigned int dest : 2;		/* Destination op addressing method ID */
+			unsigned int src : 2;		/* Source op addressing method ID */
+			unsigned int opcode : 4;	/* Command ID */
+			unsigned int unUsed : 4;  	/* Bits have no use */
+		} cmdBits;	/*Refering to the first 'word' in the translation */
+
+		/* Registers (only 12 bits) */
+		struct
+		{
+			unsigned int destBits : 3;
+			unsigned int srcBits : 3;
+		} regBits;
+
+		/* Other operands */
+		int value : 12; /* (12 bits) */
+
+	} valueBits; /* End of 12 bits union */
+
+} memoryWord;
+
+/* Single Pass */
+
+/* A label operand which is written to the memory only when all the labels are known (see --single-pass) */
+typedef struct
+{
+	char *labelName;
+	int labelInd;					/* The label if it was known when the line was encoded (data or extern), or -1 */
+	int wordInd;					/* The index of the operand word in ctx->codeArr */
+	opType type;					/* LABEL or INDEX */
+	bool isDest;					/* Whether it's the 2nd operand */
+	int lineNum;
+} fixup;
+
+/* A use of an extern label (a line in the .ext file) */
+typedef struct
+{
+	int labelInd;					/* The index of the extern label in labelArr */
+	int address;					/* The address of the operand word */
+} externRef;
+
+/* Line Cache */
+
+/* A reference to a label in a cached line */
+typedef struct
+{
+	char *name;
+	int wordInd;					/* The index of the operand word in the words of the line */
+	opType type;					/* LABEL or INDEX */
+	bool isDest;
+} cachedRef;
+
+/* The result of parsing and encoding a line without errors (see lineCache.c). */
+/* It doesn't depend on the place of the line in the file, so it fits every line with the same text and macros. */
+typedef struct
+{
+	unsigned int hash;				/* The hash of the text and macroHash */
+	unsigned int macroHash;			/* The state of the macros the line was parsed with */
+	char *text;						/* The text of the line, before parsing it */
+	int textLength;
+	bool isData;					/* TRUE if the words are data (.data/.string), FALSE if they are command words */
+	char *labelName;				/* The label of the line, or NULL */
+	int *words;
+	int wordsNum;
+	cachedRef *refs;				/* The label operands (their words are written by fixups) */
+	int refsNum;
+	bool isUsed;					/* TRUE if a line of the current assembly has it (only these lines are saved) */
+} cachedLine;
+
+/* The state before parsing a line, used to cache the result of the parsing (see addToLineCache) */
+typedef struct
+{
+	char *text;						/* A copy of the line (parseLine changes the line) */
+	int textLength;
+	int codeNum;
+	int DC;
+	int macroNum;
+	int messagesNum;
+} lineCacheMark;
+
+/* The cached lines of a file (loaded from and saved to its .cache file) */
+typedef struct
+{
+	cachedLine *linesArr;			/* Allocated by malloc and grows when needed (the lines data is in the arena) */
+	int linesNum;
+	int linesArrSize;
+	hashIndex index;				/* The lines by their hash */
+	unsigned int macroHash;			/* The state of the macros at the current line */
+	int usedNum;					/* The number of cached lines with isUsed */
+	bool isChanged;					/* TRUE if lines were added, so the .cache file must be saved */
+	long hitsNum;					/* The number of lines which weren't parsed thanks to the cache */
+} lineCache;
+
+/* === Line Scanner === */
+
+/* The break chars of the line which is parsed (see scanLine) */
+typedef struct
+{
+	char *start;					/* The scanned line (NULL if there isn't) */
+	int length;
+	unsigned int breaks[SCAN_BLOCKS_NUM];	/* A bit for every break char, SCAN_BLOCK_SIZE bits for each block */
+} lineScan;
+
+/* === Parallel First Read === */
+
+/* The symbol tables (see keepLookup) */
+typedef enum { LOOKUP_LABEL = 0, LOOKUP_MACRO, LOOKUP_ENTRY } lookupKind;
+
+/* A name which was looked up while a chunk of the file was parsed on its own (see parallelRead.c) */
+typedef struct
+{
+	unsigned int hash;				/* The hash of the name (see getNameHash) */
+	lookupKind kind;
+} symbolLookup;
+
+/* === Memory Arena === */
+
+/* A block of arena memory. The allocations are taken from the bytes after this header. */
+typedef struct arenaBlock
+{
+	struct arenaBlock *next;
+	size_t size;					/* The number of bytes after the header */
+	size_t used;					/* The number of bytes already taken */
+} arenaBlock;
+
+/* Bump allocator. All the allocations are released at once by arenaReset, and the blocks are reused. */
+typedef struct
+{
+	arenaBlock *first;				/* The blocks list, allocated by malloc */
+	arenaBlock *current;			/* The block allocations are taken from (NULL after a reset) */
+	long allocsNum;					/* The number of allocations taken from the arena */
+	long blocksNum;					/* The number of blocks allocated by malloc */
+} memoryArena;
+
+/* === Output Files === */
+
+/* The content of an output file, built in the arena and written at once (see writeOutputFile). */
+typedef struct
+{
+	char *data;
+	size_t size;					/* The number of bytes in data */
+	size_t capacity;				/* The number of bytes allocated for data */
+	bool failed;					/* TRUE if an append failed (not enough memory) */
+} outputBuffer;
+
+/* === Statistics === */
+
+/* The phases timed by --stats */
+typedef enum { STATS_READ = 0, STATS_FIRST, STATS_SECOND, STATS_OBJECT, STATS_EXTERN, STATS_ENTRIES, STATS_BINARY, STATS_CACHE, STATS_PHASES_NUM } statsPhase;
+
+/* The statistics of a file, or the sum of a few files (see --stats) */
+typedef struct
+{
+	double seconds[STATS_PHASES_NUM];	/* The wall time of every phase */
+	long filesNum;
+	long failedNum;					/* Files with errors (without output files) */
+	long linesNum;
+	long wordsNum;					/* IC + DC */
+	long lookupsNum;				/* Label and macro lookups (see getLabel and getMacro) */
+	long allocsNum;					/* Arena allocations */
+	long blocksNum;					/* Arena blocks allocated by malloc */
+	long bytesWritten;				/* The bytes of all the output files */
+} assemblyStats;
+
+/* === Assembly Context === */
+
+/* The output files formats (a bit for each format) */
+typedef enum { FORMAT_TEXT = 1, FORMAT_BIN = 2, FORMAT_BOTH = 3 } outputFormat;
+
+/* The settings of the assembler, the same for all the files */
+typedef struct
+{
+	int maxWords;					/* Max number of memory words (the address width rule), 0 means no limit */
+	bool singlePass;				/* Encode the lines while reading them (see --single-pass) */
+	bool useCache;					/* Reuse the lines of the last assembly of the file (see --cache, needs singlePass) */
+	outputFormat format;			/* The formats of the output files (see --format) */
+	bool stats;						/* Time the phases and print the statistics of every file (see --stats) */
+	bool stream;					/* Read, parse and encode the file at the same time (see --stream, needs singlePass) */
+	int threadsNum;					/* The number of threads which read each file (see --threads) */
+} assemblyOptions;
+
+/* The kinds of the messages of an assembly */
+typedef enum { MESSAGE_ERROR = 0, MESSAGE_WARNING } messageKind;
+
+/* Gets an error or a warning of an assembly when it's printed (see printError). lineNum is 0 if the message */
+/* isn't about a line, and the text (without "[Error] At line N: " and '\n') is valid only during the call. */
+typedef void (*messageHandler)(void *data, messageKind kind, int lineNum, const char *text);
+
+/* The state of streaming a file (see stream.c) */
+typedef struct streamState streamState;
+
+/* The chunks of the parallel first read (see parallelRead.c) */
+typedef struct parallelState parallelState;
+
+/* All the state of assembling a file. */
+/* Every assembly gets its own context, so a few files can be assembled at the same time. */
+typedef struct
+{
+	/* Labels (labelArr is allocated by malloc and grows when needed) */
+	labelInfo *labelArr;
+	int labelNum;
+	int labelArrSize;
+	hashIndex labelIndex;
+	/* Macros (macroArr is allocated by malloc and grows when needed) */
+	macro *macroArr;
+	int macroNum;
+	int macroArrSize;
+	hashIndex macroIndex;
+	/* Entry Labels (entryArr is allocated by malloc and grows when needed) */
+	entryLabel *entryArr;
+	int entryLabelsNum;
+	int entryArrSize;
+	hashIndex entryIndex;
+	/* Data (dataArr is allocated by malloc and grows when needed) */
+	int *dataArr;
+	int dataArrSize;
+	/* Instructions of the second read (instrArr is allocated by malloc and grows when needed) */
+	instruction *instrArr;
+	int instrNum;
+	int instrArrSize;
+	/* Single Pass (the arrays are allocated by malloc and grow when needed) */
+	int *codeArr;					/* The command words, encoded while reading the file */
+	int codeNum;
+	int codeArrSize;
+	fixup *fixupArr;				/* The label operands which weren't known when their line was encoded */
+	int fixupNum;
+	int fixupArrSize;
+	externRef *externArr;			/* The uses of extern labels, in the order of their addresses */
+	int externNum;
+	int externArrSize;
+	/* Line Cache (see --cache) */
+	lineCache cache;
+	/* Parallel First Read (see --threads) */
+	symbolLookup *lookupArr;		/* The names looked up while keepLookups is TRUE (allocated by malloc and grows when needed) */
+	int lookupNum;
+	int lookupArrSize;
+	bool keepLookups;				/* TRUE in the contexts of the chunks of a parallel read */
+	bool lookupsFailed;				/* TRUE if a lookup couldn't be kept (not enough memory) */
+	parallelState *parallel;		/* The chunks of the file (NULL until the first parallel read) */
+	/* Settings */
+	assemblyOptions options;
+	/* Memory */
+	memoryArena arena;				/* The memory of the current file (reset when the file is done) */
+	char *source;					/* The whole source file, in the arena (all the lines point into it) */
+	lineScan scan;					/* The break chars of the current line */
+	streamState *stream;			/* The stages of the current file in stream mode (NULL otherwise) */
+	/* Files */
+	char *workDir;					/* The directory of relative file names (NULL - the current directory, see --serve) */
+	char *outDir;					/* The directory of the output files (NULL - next to the source file) */
+	char *includeDir;				/* The directory of the .include files with its '/' ("" - the current directory), */
+									/* or NULL if the source can't include files (see include.c) */
+	/* Messages */
+	FILE *log;						/* Where the info, warnings and errors of the assembly are printed (NULL - only onMessage) */
+	int messagesNum;				/* The number of errors and warnings printed */
+	messageHandler onMessage;		/* Called with every error and warning (NULL if there isn't), only in the thread */
+	void *messageData;				/* of the context (the contexts of the threads of a file don't have it) */
+	/* Statistics (the counters are always updated, the phases are timed only with --stats) */
+	assemblyStats stats;			/* The current file */
+	assemblyStats totalStats;		/* All the files assembled with the context */
+} assemblyContext;
+
+
+/* ======== Globals Declaration ======== */
+extern const unsigned char g_charClass[256];
+
+/* ======== Methods Declaration ======== */
+
+/* utility.c methods */
+const reservedWord *getReservedWord(const char *str);
+int getCmdId(char *cmdName);
+labelInfo *getLabel(assemblyContext *ctx, char *labelName);
+void trimLeftStr(char **ptStr);
+void trimStr(char **ptStr);
+char *getFirstTok(char *str, char **endOfTok);
+bool isOneWord(char *str);
+bool isWhiteSpaces(char *str);
+bool isLegalLabel(assemblyContext *ctx, char *label, int lineNum, bool printErrors);
+bool isExistingLabel(assemblyContext *ctx, char *label);
+bool isExistingEntryLabel(assemblyContext *ctx, char *labelName);
+bool isRegister(char *str, int *value);
+bool isCommentOrEmpty(assemblyContext *ctx, lineInfo *line);
+char *getFirstOperand(assemblyContext *ctx, char *line, char **endOfOp, bool *foundComma);
+bool isDirective(char *cmd);
+bool isMacro(char *cmd);
+bool isLegalStringParam(assemblyContext *ctx, char **strParam, int lineNum);
+int getCmdOpCode(char *cmdName);
+bool isLegalNum(assemblyContext *ctx, char *numStr, int numOfBits, int lineNum, int *value);
+macro *getMacro(assemblyContext *ctx, char *macroName);
+bool isExistingMacro(assemblyContext *ctx, char *macro);
+int *getMacroValue(macro *mac,int *val);
+int getIndexValue(operandInfo *operand);
+int getAddressValue(operandInfo *operand);
+unsigned int getNameHash(const char *name);
+bool addToHashIndex(hashIndex *index, unsigned int hash, int arrIndex);
+void removeFromHashIndex(hashIndex *index, unsigned int hash, int arrIndex);
+bool isHashInIndex(hashIndex *index, unsigned int hash, int firstIndex);
+bool copyHashIndex(hashIndex *dest, hashIndex *src);
+void keepLookup(assemblyContext *ctx, unsigned int hash, lookupKind kind);
+void clearHashIndex(hashIndex *index);
+void freeHashIndex(hashIndex *index);
+void *arenaAlloc(memoryArena *arena, size_t size);
+void *arenaGrow(memoryArena *arena, void *ptr, size_t oldSize, size_t newSize);
+void arenaReset(memoryArena *arena);
+void arenaFree(memoryArena *arena);
+bool growArray(void **arr, int *arrSize, int itemsNum, size_t itemSize);
+lineInfo *addLine(memoryArena *arena, linesList *lines);
+bool joinLines(memoryArena *arena, linesList *lines, linesList *other);
+lineInfo *getLine(linesList *lines, int lineInd);
+bool isBelowMemoryLimit(assemblyContext *ctx, int wordsNum);
+void appendOutput(memoryArena *arena, outputBuffer *output, const char *str, size_t len);
+void appendOutputStr(memoryArena *arena, outputBuffer *output, const char *str);
+void appendOutputNum(memoryArena *arena, outputBuffer *output, int num);
+void appendOutputUint(memoryArena *arena, outputBuffer *output, unsigned long num, int bytesNum);
+
+/* firstRead.c methods */
+char *readSourceFile(memoryArena *arena, FILE *file, size_t *size);
+int firstFileRead(assemblyContext *ctx, char *source, size_t sourceSize, linesList *lines, int *IC, int *DC);
+void findMacroName(assemblyContext *ctx, lineInfo *line);
+bool areLegalOpTypes(assemblyContext *ctx, const command *cmd, operandInfo *op1, operandInfo *op2, int lineNum);
+bool addNumberToData(assemblyContext *ctx, int num, int *IC, int *DC, int lineNum);
+labelInfo *addLabelToArr(assemblyContext *ctx, labelInfo label, lineInfo *line);
+void removeLastLabel(assemblyContext *ctx, int lineNum);
+void parseLine(assemblyContext *ctx, lineInfo *line, char *lineStr, int lineNum, int *IC, int *DC);
+/* secondRead.c methods */
+int secondFileRead(assemblyContext *ctx, int *memoryArr, linesList *lines, int IC, int DC);
+void updateDataLabelsAddress(assemblyContext *ctx, int IC);
+int countIllegalEntries(assemblyContext *ctx);
+int addInstructionsToMemory(assemblyContext *ctx, int *memoryArr, int memorySize, linesList *lines, int firstInstr, int lastInstr);
+void addDataToMemory(assemblyContext *ctx, int *memoryArr, int *memoryCounter, int memorySize, int DC);
+bool addInstruction(assemblyContext *ctx, lineInfo *line, int lineInd);
+void addCmdWordsToMemory(int *memoryArr, int *memoryCounter, int memorySize, const instruction *instr);
+int getOpWordOffset(const instruction *instr, bool isDest);
+void setInstruction(instruction *instr, const lineInfo *line, int lineInd, int wordInd);
+bool encodeLine(assemblyContext *ctx, lineInfo *line);
+bool addFixup(assemblyContext *ctx, char *labelName, int labelInd, opType type, int wordInd, bool isDest, int lineNum);
+bool addExternRef(assemblyContext *ctx, int labelInd, int address);
+int finishSinglePass(assemblyContext *ctx, int *memoryArr, int IC, int DC);
+
+/* lineCache.c methods */
+void loadLineCache(assemblyContext *ctx, char *name);
+void saveLineCache(assemblyContext *ctx, char *name);
+cachedLine *findCachedLine(assemblyContext *ctx, char *text, int textLength);
+bool replayCachedLine(assemblyContext *ctx, cachedLine *cached, lineInfo *line, int lineNum, int *IC, int *DC);
+bool markLineCache(assemblyContext *ctx, lineCacheMark *mark, char *text, int textLength, int DC);
+void addToLineCache(assemblyContext *ctx, lineCacheMark *mark, lineInfo *line, int DC);
+
+/* lineScan.c methods */
+void scanLine(lineScan *scan, char *line, int length);
+char *findLineChar(lineScan *scan, char *str, char c);
+
+/* parallelRead.c methods */
+int parallelFileRead(assemblyContext *ctx, char *source, size_t sourceSize, linesList *lines, int *IC, int *DC);
+int parallelSecondRead(assemblyContext *ctx, int *memoryArr, linesList *lines, int IC, int DC);
+void clearParallelRead(assemblyContext *ctx);
+void freeParallelRead(assemblyContext *ctx);
+
+/* stream.c methods */
+int streamFileRead(assemblyContext *ctx, FILE *file, int *IC, int *DC);
+bool streamLine(assemblyContext *ctx, lineInfo *line);
+void writeStreamObjectFile(assemblyContext *ctx, char *name, int IC, int DC, int *memoryArr);
+void freeStream(assemblyContext *ctx);
+
+/* include.c methods */
+void parseIncludeDirc(assemblyContext *ctx, lineInfo *line);
+void freeIncludeCache();
+
+/* serve.c methods */
+int serveAssembler(char *socketPath, int jobsNum, assemblyOptions options);
+int runClient(char *socketPath, char **fileNames, int filesNum, assemblyOptions options, char *outDir, bool sendSource,
+	assemblyStats *totalStats);
+
+/* assembler.c methods */
+void printMessage(assemblyContext *ctx, messageKind kind, int lineNum, char *text, char *buffer);
+void printError(assemblyContext *ctx, int lineNum, const char *format, ...);
+void printWarning(assemblyContext *ctx, int lineNum, const char *format, ...);
+void printLog(FILE *log, FILE *out);
+FILE *openFile(assemblyContext *ctx, char *name, char *ending, const char *mode);
+char *getOutputName(assemblyContext *ctx, char *name);
+char *getIncludeDir(assemblyContext *ctx, char *name);
+void writeOutputParts(assemblyContext *ctx, char *name, char *ending, outputBuffer *partsArr, int partsNum);
+void writeOutputFile(assemblyContext *ctx, char *name, char *ending, outputBuffer *output);
+void initBase4Table();
+char *encodeBase4Spcl(int num, char *buffer);
+void appendObjectLines(memoryArena *arena, outputBuffer *output, int *memoryArr, int firstWord, int lastWord);
+void createObjectFile(assemblyContext *ctx, char *name, int IC, int DC, int *memoryArr);
+void createEntriesFile(assemblyContext *ctx, char *name);
+void createExternFile(assemblyContext *ctx, char *name);
+void createBinaryFile(assemblyContext *ctx, char *name, int IC, int DC, int *memoryArr);
+assemblyContext *createContext();
+void freeContext(assemblyContext *ctx);
+void clearData(assemblyContext *ctx);
+void parseFile(assemblyContext *ctx, char *fileName);
+void assembleFile(assemblyContext *ctx, char *fileName, FILE *file);
+int *encodeMemoryImage(assemblyContext *ctx, linesList *lines, int IC, int DC, int *numOfErrors);
+double getWallTime();
+void addStats(assemblyStats *total, assemblyStats *stats);
+void printStats(FILE *out, char *name, assemblyStats *stats, double wallTime);
+
+#endif
@@ -0,0 +1,309 @@
+/*
+Throughput benchmark of the assembler (see "make bench").
+It assembles every file a few times with the same phases as parseFile, and times each phase:
+reading the source, the first read, the second read (or the fixups in single pass mode) and the output writers.
+The best time of every phase is kept, and reported as lines/sec and words/sec on stdout and in a JSON file.
+Usage: benchRun [-r repeats] [-o results.json] [--single-pass] [--threads N] [--format=text|bin|both] file...
+*/
+
+/* ======== Includes ======== */
+#include "../assembler.h"
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* ======== Macros ======== */
+#define DEFAULT_REPEATS		5
+#define PHASES_NUM			4
+
+/* ====== Data Structures ====== */
+
+/* The phases of assembling a file */
+typedef enum { PHASE_READ = 0, PHASE_FIRST, PHASE_SECOND, PHASE_WRITE } benchPhase;
+
+const char *g_phaseNames[PHASES_NUM] = { "read", "firstFileRead", "secondFileRead", "writers" };
+
+/* The results of a file */
+typedef struct
+{
+	char *name;
+	long linesNum;					/* The lines of the source file */
+	long wordsNum;					/* The memory words of the file (IC + DC) */
+	int errorsNum;
+	double seconds[PHASES_NUM];		/* The best time of each phase */
+} fileResult;
+
+/* ====== Methods ====== */
+
+/* Returns the time in seconds of a monotonic clock. */
+double getTime()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* Returns the number of lines of the source. */
+long countLines(char *source, size_t sourceSize)
+{
+	long linesNum = 0;
+	size_t i;
+
+	for (i = 0; i < sourceSize; i++)
+	{
+		if (source[i] == '\n')
+		{
+			linesNum++;
+		}
+	}
+	return (sourceSize && source[sourceSize - 1] != '\n') ? linesNum + 1 : linesNum;
+}
+
+/* Keeps the time since 'start' in 'best' if it's the best so far. Returns the current time. */
+double keepBest(double start, double *best)
+{
+	double end = getTime();
+
+	if (*best < 0 || end - start < *best)
+	{
+		*best = end - start;
+	}
+	return end;
+}
+
+/* Assembles the file once, like parseFile, and keeps the best time of every phase. */
+/* Returns "FALSE" if the file can't be read. */
+bool benchFile(assemblyContext *ctx, fileResult *result)
+{
+	FILE *file;
+	linesList lines = { 0 };
+	int *memoryArr, IC = 0, DC = 0;
+	size_t sourceSize;
+	double start = getTime();
+
+	/* Read */
+	file = openFile(ctx, result->name, ".as", "r");
+	if (!file)
+	{
+		arenaReset(&ctx->arena);
+		return FALSE;
+	}
+	ctx->source = readSourceFile(&ctx->arena, file, &sourceSize);
+	fclose(file);
+	if (!ctx->source)
+	{
+		clearData(ctx);
+		return FALSE;
+	}
+	start = keepBest(start, &result->seconds[PHASE_READ]);
+	result->linesNum = countLines(ctx->source, sourceSize);
+
+	/* First Read */
+	result->errorsNum = parallelFileRead(ctx, ctx->source, sourceSize, &lines, &IC, &DC);
+	start = keepBest(start, &result->seconds[PHASE_FIRST]);
+	result->wordsNum = IC + DC;
+
+	/* Second Read */
+	memoryArr = encodeMemoryImage(ctx, &lines, IC, DC, &result->errorsNum);
+	if (!memoryArr)
+	{
+		clearData(ctx);
+		return FALSE;
+	}
+	start = keepBest(start, &result->seconds[PHASE_SECOND]);
+
+	/* Output Files */
+	if (result->errorsNum == 0)
+	{
+		if (ctx->options.format & FORMAT_TEXT)
+		{
+			createObjectFile(ctx, result->name, IC, DC, memoryArr);
+			createExternFile(ctx, result->name);
+			createEntriesFile(ctx, result->name);
+		}
+		if (ctx->options.format & FORMAT_BIN)
+		{
+			createBinaryFile(ctx, result->name, IC, DC, memoryArr);
+		}
+	}
+	keepBest(start, &result->seconds[PHASE_WRITE]);
+
+	clearData(ctx);
+	return TRUE;
+}
+
+/* Returns 'num' per second of 'seconds' (0 if the time is too short to measure). */
+double getRate(long num, double seconds)
+{
+	return (seconds > 0) ? num / seconds : 0;
+}
+
+/* Prints the JSON object of a file (or of the total). */
+void printResultJson(FILE *out, fileResult *result, const char *indent)
+{
+	int i;
+	double total = 0;
+
+	fprintf(out, "{\n%s  \"name\": \"%s\",\n", indent, result->name);
+	fprintf(out, "%s  \"lines\": %ld,\n%s  \"words\": %ld,\n%s  \"errors\": %d,\n",
+		indent, result->linesNum, indent, result->wordsNum, indent, result->errorsNum);
+	fprintf(out, "%s  \"phases\": {\n", indent);
+	for (i = 0; i < PHASES_NUM; i++)
+	{
+		fprintf(out, "%s    \"%s\": { \"seconds\": %.6f, \"linesPerSec\": %.0f, \"wordsPerSec\": %.0f }%s\n",
+			indent, g_phaseNames[i], result->seconds[i], getRate(result->linesNum, result->seconds[i]),
+			getRate(result->wordsNum, result->seconds[i]), (i < PHASES_NUM - 1) ? "," : "");
+		total += result->seconds[i];
+	}
+	fprintf(out, "%s  },\n", indent);
+	fprintf(out, "%s  \"seconds\": %.6f,\n%s  \"linesPerSec\": %.0f,\n%s  \"wordsPerSec\": %.0f\n%s}",
+		indent, total, indent, getRate(result->linesNum, total), indent, getRate(result->wordsNum, total), indent);
+}
+
+/* Writes all the results to a JSON file. Returns "FALSE" if the file can't be written. */
+bool writeResultsJson(char *fileName, fileResult *resultsArr, int filesNum, fileResult *total, int repeats, assemblyOptions *options)
+{
+	FILE *out = fopen(fileName, "w");
+	int i;
+
+	if (!out)
+	{
+		return FALSE;
+	}
+
+	fprintf(out, "{\n  \"repeats\": %d,\n  \"singlePass\": %s,\n  \"threads\": %d,\n  \"format\": %d,\n  \"files\": [\n",
+		repeats, options->singlePass ? "true" : "false", options->threadsNum, (int)options->format);
+	for (i = 0; i < filesNum; i++)
+	{
+		fprintf(out, "    ");
+		printResultJson(out, &resultsArr[i], "    ");
+		fprintf(out, "%s\n", (i < filesNum - 1) ? "," : "");
+	}
+	fprintf(out, "  ],\n  \"total\": ");
+	printResultJson(out, total, "  ");
+	fprintf(out, "\n}\n");
+
+	return fclose(out) == 0 ? TRUE : FALSE;
+}
+
+/* Prints a line of the results table. */
+void printResultRow(fileResult *result)
+{
+	int i;
+
+	printf("%-24s %9ld %9ld", result->name, result->linesNum, result->wordsNum);
+	for (i = 0; i < PHASES_NUM; i++)
+	{
+		printf(" %14.0f", getRate(result->linesNum, result->seconds[i]));
+	}
+	printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+	int i, j, repeats = DEFAULT_REPEATS, filesNum = 0;
+	char *jsonName = NULL;
+	assemblyOptions options = { 0, FALSE, FALSE, FORMAT_TEXT, FALSE, FALSE, 1 };
+	fileResult *resultsArr = (fileResult *)calloc(argc, sizeof(fileResult));
+	fileResult total = { "total", 0, 0, 0, { 0 } };
+	assemblyContext *ctx = createContext();
+	FILE *log = fopen("/dev/null", "w");
+
+	if (!resultsArr || !ctx || !log)
+	{
+		fprintf(stderr, "[Error] Not enough memory - malloc falied.\n");
+		return 1;
+	}
+
+	/* Separate the options from the file names */
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+		{
+			repeats = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+		{
+			jsonName = argv[++i];
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			options.threadsNum = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--single-pass") == 0)
+		{
+			options.singlePass = TRUE;
+		}
+		else if (strncmp(argv[i], "--format=", 9) == 0)
+		{
+			options.format = (strcmp(argv[i] + 9, "bin") == 0) ? FORMAT_BIN :
+				(strcmp(argv[i] + 9, "both") == 0) ? FORMAT_BOTH : FORMAT_TEXT;
+		}
+		else
+		{
+			resultsArr[filesNum].name = argv[i];
+			for (j = 0; j < PHASES_NUM; j++)
+			{
+				resultsArr[filesNum].seconds[j] = -1;
+			}
+			filesNum++;
+		}
+	}
+
+	if (filesNum < 1 || repeats < 1 || options.threadsNum < 1)
+	{
+		fprintf(stderr, "Usage: benchRun [-r repeats] [-o results.json] [--single-pass] [--threads N] [--format=text|bin|both] file...\n");
+		return 1;
+	}
+
+	/* The messages of the assembler aren't part of the benchmark */
+	initBase4Table();
+	ctx->options = options;
+	ctx->log = log;
+
+	printf("%-24s %9s %9s", "file", "lines", "words");
+	for (j = 0; j < PHASES_NUM; j++)
+	{
+		printf(" %14s", g_phaseNames[j]);
+	}
+	printf("\n%-44s (lines/sec of each phase)\n", "");
+
+	for (i = 0; i < filesNum; i++)
+	{
+		for (j = 0; j < repeats; j++)
+		{
+			if (!benchFile(ctx, &resultsArr[i]))
+			{
+				fprintf(stderr, "[Error] Can't assemble the file \"%s.as\".\n", resultsArr[i].name);
+				return 1;
+			}
+		}
+		if (resultsArr[i].errorsNum)
+		{
+			fprintf(stderr, "[Warning] The file \"%s.as\" has %d errors.\n", resultsArr[i].name, resultsArr[i].errorsNum);
+		}
+		printResultRow(&resultsArr[i]);
+
+		/* Sum the files */
+		total.linesNum += resultsArr[i].linesNum;
+		total.wordsNum += resultsArr[i].wordsNum;
+		total.errorsNum += resultsArr[i].errorsNum;
+		for (j = 0; j < PHASES_NUM; j++)
+		{
+			total.seconds[j] += resultsArr[i].seconds[j];
+		}
+	}
+	printResultRow(&total);
+
+	if (jsonName && !writeResultsJson(jsonName, resultsArr, filesNum, &total, repeats, &options))
+	{
+		fprintf(stderr, "[Error] Can't write the file \"%s\".\n", jsonName);
+		return 1;
+	}
+
+	fclose(log);
+	freeContext(ctx);
+	free(resultsArr);
+	return 0;
+}
@@ -0,0 +1,340 @@
+/*
+Synthetic source generator for the benchmarks (see "make bench").
+It writes a legal .as file with a configurable number of lines and mix of line kinds, so all the
+phases of the assembler run on it (the labels it uses are always defined somewhere in the file).
+Usage: genSource [-n lines] [-s seed] [-l label%] [-d data%] [-t string%] [-i index%] [-x externs] [-e entries] [-m defines] > file.as
+*/
+
+/* ======== Includes ======== */
+#include "../assembler.h"
+#include <stdlib.h>
+
+/* ======== Macros ======== */
+#define DEFAULT_LINES_NUM	10000
+#define MAX_NUM_VALUE		2000	/* Numbers stay far from the limits of a memory word */
+
+/* ====== Data Structures ====== */
+
+/* Line kinds of the body of the file */
+typedef enum { LINE_COMMAND = 0, LINE_DATA, LINE_STRING } lineKind;
+
+/* The settings of the generated file */
+typedef struct
+{
+	long linesNum;
+	unsigned long seed;
+	int labelPercent;				/* Lines with a label */
+	int dataPercent;				/* .data lines */
+	int stringPercent;				/* .string lines */
+	int indexPercent;				/* Label operands which are index operands */
+	int externsNum;					/* .extern lines (their labels are used by some operands) */
+	int entriesNum;					/* .entry lines */
+	int definesNum;					/* .define lines (their macros are used by numbers and indexes) */
+} genOptions;
+
+/* ====== Commands List ====== */
+typedef struct
+{
+	const char *name;
+	int opcode;
+	int numOfParams;
+} genCommand;
+
+const genCommand g_genCmdArr[] =
+{
+#define COMMAND(name, opcode, numOfParams)	{ #name, opcode, numOfParams },
+#include "../reservedWords.def"
+	{ NULL }
+};
+
+/* ====== Globals ====== */
+unsigned long g_randState;
+long *g_labelLines;					/* The line of each label in the body */
+long g_labelsNum;
+
+/* ====== Methods ====== */
+
+/* Returns the next 15 random bits of a 32 bit LCG. */
+unsigned long getRandomBits()
+{
+	g_randState = (g_randState * 1103515245UL + 12345UL) & 0xFFFFFFFFUL;
+	return (g_randState >> 16) & 0x7FFF;
+}
+
+/* Returns a pseudo random number in [0, limit). The same seed always gives the same file. */
+long getRandom(long limit)
+{
+	return (long)(((getRandomBits() << 15) | getRandomBits()) % (unsigned long)limit);
+}
+
+/* Returns TRUE with a probability of 'percent'. */
+bool getChance(int percent)
+{
+	return getRandom(100) < percent ? TRUE : FALSE;
+}
+
+/* Prints the name of a random label, index operand or extern label (a register if there aren't labels). */
+void printLabelOperand(genOptions *opt, bool allowIndex)
+{
+	if (opt->externsNum && getChance(10))
+	{
+		printf("X%ld", getRandom(opt->externsNum));
+		return;
+	}
+
+	if (!g_labelsNum)
+	{
+		printf("r%ld", getRandom(MAX_REGISTER_DIGIT + 1));
+		return;
+	}
+
+	printf("L%ld", g_labelLines[getRandom(g_labelsNum)]);
+	if (allowIndex && getChance(opt->indexPercent))
+	{
+		if (opt->definesNum && getChance(50))
+		{
+			printf("[c%ld]", getRandom(opt->definesNum));
+		}
+		else
+		{
+			printf("[%ld]", getRandom(10));
+		}
+	}
+}
+
+/* Prints a random number operand (a macro or a literal). */
+void printNumberOperand(genOptions *opt)
+{
+	if (opt->definesNum && getChance(30))
+	{
+		printf("#c%ld", getRandom(opt->definesNum));
+	}
+	else
+	{
+		printf("#%ld", getRandom(2 * MAX_NUM_VALUE + 1) - MAX_NUM_VALUE);
+	}
+}
+
+/* Prints a random legal operand (see areLegalOpTypes). */
+void printOperand(genOptions *opt, bool allowNumber)
+{
+	long kind = getRandom(allowNumber ? 3 : 2);
+
+	if (kind == 0)
+	{
+		printf("r%ld", getRandom(MAX_REGISTER_DIGIT + 1));
+	}
+	else if (kind == 1)
+	{
+		printLabelOperand(opt, TRUE);
+	}
+	else
+	{
+		printNumberOperand(opt);
+	}
+}
+
+/* Prints a random command line (without its label). */
+void printCommand(genOptions *opt)
+{
+	const genCommand *cmd = &g_genCmdArr[getRandom(sizeof(g_genCmdArr) / sizeof(genCommand) - 1)];
+
+	/* lea needs a label */
+	if (cmd->opcode == 6 && !g_labelsNum && !opt->externsNum)
+	{
+		cmd = &g_genCmdArr[0];
+	}
+
+	printf("%s", cmd->name);
+	if (cmd->numOfParams == 2)
+	{
+		printf(" ");
+		/* lea can only get a label as the source */
+		if (cmd->opcode == 6)
+		{
+			printLabelOperand(opt, FALSE);
+		}
+		else
+		{
+			printOperand(opt, TRUE);
+		}
+		printf(", ");
+	}
+	if (cmd->numOfParams >= 1)
+	{
+		if (cmd->numOfParams == 1)
+		{
+			printf(" ");
+		}
+		/* Only cmp and prn can get a number as the destination */
+		printOperand(opt, (cmd->opcode == 1 || cmd->opcode == 12) ? TRUE : FALSE);
+	}
+	printf("\n");
+}
+
+/* Prints a random .data line (without its label). */
+void printData(genOptions *opt)
+{
+	long i, valuesNum = 1 + getRandom(6);
+
+	printf(".data ");
+	for (i = 0; i < valuesNum; i++)
+	{
+		if (opt->definesNum && getChance(20))
+		{
+			printf("%sc%ld", i ? ", " : "", getRandom(opt->definesNum));
+		}
+		else
+		{
+			printf("%s%ld", i ? ", " : "", getRandom(2 * MAX_NUM_VALUE + 1) - MAX_NUM_VALUE);
+		}
+	}
+	printf("\n");
+}
+
+/* Prints a random .string line (without its label). */
+void printString()
+{
+	long i, length = 1 + getRandom(20);
+
+	printf(".string \"");
+	for (i = 0; i < length; i++)
+	{
+		printf("%c", (char)('a' + getRandom(26)));
+	}
+	printf("\"\n");
+}
+
+/* Reads a number option. Returns "FALSE" if it's missing or negative. */
+bool readOption(char *str, long *value)
+{
+	char *end;
+
+	if (!str)
+	{
+		return FALSE;
+	}
+
+	*value = strtol(str, &end, 10);
+	return (*end == '\0' && *value >= 0) ? TRUE : FALSE;
+}
+
+/* Parses the command line into opt. Returns "FALSE" if it isn't legal. */
+bool parseOptions(int argc, char *argv[], genOptions *opt)
+{
+	int i;
+	long value;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (argv[i][0] != '-' || !argv[i][1] || argv[i][2] || !readOption(argv[i + 1], &value))
+		{
+			return FALSE;
+		}
+
+		switch (argv[i++][1])
+		{
+			case 'n': opt->linesNum = value; break;
+			case 's': opt->seed = (unsigned long)value; break;
+			case 'l': opt->labelPercent = (int)value; break;
+			case 'd': opt->dataPercent = (int)value; break;
+			case 't': opt->stringPercent = (int)value; break;
+			case 'i': opt->indexPercent = (int)value; break;
+			case 'x': opt->externsNum = (int)value; break;
+			case 'e': opt->entriesNum = (int)value; break;
+			case 'm': opt->definesNum = (int)value; break;
+			default: return FALSE;
+		}
+	}
+
+	return (opt->dataPercent + opt->stringPercent <= 100) ? TRUE : FALSE;
+}
+
+int main(int argc, char *argv[])
+{
+	genOptions opt = { DEFAULT_LINES_NUM, 1, 40, 10, 5, 20, 8, 8, 8 };
+	lineKind *kindsArr;
+	bool *hasLabelArr;
+	long i, bodyLinesNum, percent, step;
+
+	if (!parseOptions(argc, argv, &opt))
+	{
+		fprintf(stderr, "Usage: genSource [-n lines] [-s seed] [-l label%%] [-d data%%] [-t string%%] [-i index%%] [-x externs] [-e entries] [-m defines]\n");
+		return 1;
+	}
+
+	bodyLinesNum = opt.linesNum - opt.definesNum - opt.externsNum - opt.entriesNum;
+	if (bodyLinesNum < 1)
+	{
+		bodyLinesNum = 1;
+	}
+
+	kindsArr = (lineKind *)malloc(bodyLinesNum * sizeof(lineKind));
+	hasLabelArr = (bool *)malloc(bodyLinesNum * sizeof(bool));
+	g_labelLines = (long *)malloc(bodyLinesNum * sizeof(long));
+	if (!kindsArr || !hasLabelArr || !g_labelLines)
+	{
+		fprintf(stderr, "[Error] Not enough memory - malloc falied.\n");
+		return 1;
+	}
+
+	/* Choose the kind and label of every line first, so operands can use labels which are defined later */
+	g_randState = opt.seed;
+	for (i = 0; i < bodyLinesNum; i++)
+	{
+		percent = getRandom(100);
+		kindsArr[i] = (percent < opt.dataPercent) ? LINE_DATA :
+			(percent < opt.dataPercent + opt.stringPercent) ? LINE_STRING : LINE_COMMAND;
+		hasLabelArr[i] = getChance(opt.labelPercent);
+		if (hasLabelArr[i])
+		{
+			g_labelLines[g_labelsNum++] = i;
+		}
+	}
+
+	for (i = 0; i < opt.definesNum; i++)
+	{
+		printf(".define c%ld = %ld\n", i, getRandom(10));
+	}
+	for (i = 0; i < opt.externsNum; i++)
+	{
+		printf(".extern X%ld\n", i);
+	}
+
+	for (i = 0; i < bodyLinesNum; i++)
+	{
+		if (hasLabelArr[i])
+		{
+			printf("L%ld: ", i);
+		}
+		else
+		{
+			printf("\t");
+		}
+
+		if (kindsArr[i] == LINE_DATA)
+		{
+			printData(&opt);
+		}
+		else if (kindsArr[i] == LINE_STRING)
+		{
+			printString();
+		}
+		else
+		{
+			printCommand(&opt);
+		}
+	}
+
+	/* Each label can be an entry only once */
+	step = (opt.entriesNum && g_labelsNum > opt.entriesNum) ? g_labelsNum / opt.entriesNum : 1;
+	for (i = 0; i < opt.entriesNum && i < g_labelsNum; i++)
+	{
+		printf(".entry L%ld\n", g_labelLines[i * step]);
+	}
+
+	free(kindsArr);
+	free(hasLabelArr);
+	free(g_labelLines);
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+Build time generator of the reserved words hash.
+It finds a multiplier and a shift which make RESERVED_HASH_STEP a perfect hash of all the words
+in reservedWords.def, and prints the lookup table as a C header (see getReservedWord in utility.c).
+Usage: genReserved > reservedHash.h
+*/
+
+/* ======== Includes ======== */
+#include "assembler.h"
+#include <stdlib.h>
+
+/* ======== Macros ======== */
+#define HASH_SIZE		64		/* Must be a power of 2 */
+#define MAX_MULT		100000
+#define MAX_SHIFT		24
+
+/* ====== Reserved Words List ====== */
+typedef struct
+{
+	const char *name;
+	const char *kind;
+	int id;
+} wordInfo;
+
+wordInfo g_wordsArr[] =
+{
+#define COMMAND(name, opcode, numOfParams)	{ #name, "RESERVED_COMMAND", opcode },
+#define DIRECTIVE(name, parseFunc)			{ #name, "RESERVED_DIRECTIVE", 0 },
+#define REGISTER(name, number)				{ #name, "RESERVED_REGISTER", number },
+#define MACRO(name)							{ #name, "RESERVED_MACRO", 0 },
+#include "reservedWords.def"
+	{ NULL }
+};
+
+/* ====== Methods ====== */
+
+/* Returns the slot of 'word' in the table for the given multiplier and shift. */
+unsigned int getSlot(const char *word, unsigned int mult, unsigned int shift)
+{
+	unsigned int hash = 0;
+
+	while (*word)
+	{
+		hash = RESERVED_HASH_STEP(hash, *word++, mult);
+	}
+
+	return (hash >> shift) & (HASH_SIZE - 1);
+}
+
+/* Returns if all the words get different slots with the given multiplier and shift. */
+bool isPerfectHash(unsigned int mult, unsigned int shift)
+{
+	bool usedSlots[HASH_SIZE] = { 0 };
+	int i;
+
+	for (i = 0; g_wordsArr[i].name; i++)
+	{
+		unsigned int slot = getSlot(g_wordsArr[i].name, mult, shift);
+
+		if (usedSlots[slot])
+		{
+			return FALSE;
+		}
+		usedSlots[slot] = TRUE;
+	}
+
+	return TRUE;
+}
+
+/* Prints the header with the table for the given multiplier and shift. */
+void printTable(unsigned int mult, unsigned int shift)
+{
+	const wordInfo *slotsArr[HASH_SIZE] = { 0 };
+	int i, maxLength = 0;
+
+	for (i = 0; g_wordsArr[i].name; i++)
+	{
+		slotsArr[getSlot(g_wordsArr[i].name, mult, shift)] = &g_wordsArr[i];
+		if ((int)strlen(g_wordsArr[i].name) > maxLength)
+		{
+			maxLength = strlen(g_wordsArr[i].name);
+		}
+	}
+
+	printf("/* Generated by genReserved from reservedWords.def - don't edit. */\n\n");
+	printf("#define RESERVED_HASH_MULT\t\t%uu\n", mult);
+	printf("#define RESERVED_HASH_SHIFT\t\t%u\n", shift);
+	printf("#define RESERVED_HASH_SIZE\t\t%d\n", HASH_SIZE);
+	printf("#define RESERVED_MAX_LENGTH\t\t%d\n\n", maxLength);
+	printf("static const reservedWord g_reservedHash[RESERVED_HASH_SIZE] =\n{\n");
+
+	for (i = 0; i < HASH_SIZE; i++)
+	{
+		if (slotsArr[i])
+		{
+			printf("\t{ \"%s\", %s, %d },\n", slotsArr[i]->name, slotsArr[i]->kind, slotsArr[i]->id);
+		}
+		else
+		{
+			printf("\t{ NULL, RESERVED_NONE, 0 },\n");
+		}
+	}
+
+	printf("};\n");
+}
+
+/* Main method. Searches for a perfect hash and prints it. */
+int main()
+{
+	unsigned int mult, shift;
+	int i, dircId = 0;
+
+	/* Directives are numbered by their order in the list (their index in g_dircArr) */
+	for (i = 0; g_wordsArr[i].name; i++)
+	{
+		if (strcmp(g_wordsArr[i].kind, "RESERVED_DIRECTIVE") == 0)
+		{
+			g_wordsArr[i].id = dircId++;
+		}
+	}
+
+	for (mult = 1; mult < MAX_MULT; mult += 2)
+	{
+		for (shift = 0; shift <= MAX_SHIFT; shift++)
+		{
+			if (isPerfectHash(mult, shift))
+			{
+				printTable(mult, shift);
+				return 0;
+			}
+		}
+	}
+
+	fprintf(stderr, "[Error] No perfect hash was found for the reserved words.\n");
+	return 1;
+}
@@ -0,0 +1,186 @@
+/*
+The embeddable assembler library (see imasm.h).
+It runs the same first and second read as the command line, on a copy of the source in the arena of the context.
+Every error and warning is passed to addDiagnostic when it's printed (see printError), and kept in the diagnostics
+of the caller with its full text. The other lines of the log (the info lines) are printed to a memory stream.
+The reads of the library don't use threads (the messages of the threads are kept in temporary files),
+and a source in memory can't include files (see include.c).
+*/
+
+/* ======== Includes ======== */
+#include "assembler.h"
+#include "imasm.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* ====== Data Structures ====== */
+
+/* The state of the library: a context which is reused for all the sources */
+struct imasmContext
+{
+	assemblyContext *ctx;
+	imasmResult *result;			/* The result of the current source */
+	memoryArena texts;				/* The texts of the diagnostics of the last source */
+	bool textsFailed;				/* TRUE if a text couldn't be kept (not enough memory) */
+};
+
+/* ====== Methods ====== */
+
+/* Returns a new context of the library (or NULL if malloc failed). */
+imasmContext *imasmCreate(void)
+{
+	imasmContext *asmCtx = (imasmContext *)calloc(1, sizeof(imasmContext));
+
+	if (asmCtx && !(asmCtx->ctx = createContext()))
+	{
+		free(asmCtx);
+		asmCtx = NULL;
+	}
+	return asmCtx;
+}
+
+/* Frees a context of the library. */
+void imasmFree(imasmContext *asmCtx)
+{
+	if (asmCtx)
+	{
+		freeContext(asmCtx->ctx);
+		arenaFree(&asmCtx->texts);
+		free(asmCtx);
+	}
+}
+
+/* Copies a name and an address to the item 'index' of symbolsArr, if it has a place for it. */
+void setSymbol(imasmSymbol *symbolsArr, int symbolsSize, int index, const char *name, int address)
+{
+	if (index < symbolsSize)
+	{
+		strncpy(symbolsArr[index].name, name, IMASM_NAME_SIZE - 1);
+		symbolsArr[index].name[IMASM_NAME_SIZE - 1] = '\0';
+		symbolsArr[index].address = address;
+	}
+}
+
+/* Adds an error or a warning of the assembly to the diagnostics of the result (see messageHandler). */
+/* The text is copied to the texts arena of the library context, so it isn't cut. */
+void addDiagnostic(void *data, messageKind kind, int lineNum, const char *text)
+{
+	imasmContext *asmCtx = (imasmContext *)data;
+	imasmResult *result = asmCtx->result;
+	imasmDiagnostic *diagnostic;
+	char *textCopy;
+
+	if (result->diagnosticsNum < result->diagnosticsSize)
+	{
+		diagnostic = &result->diagnostics[result->diagnosticsNum];
+		diagnostic->severity = (kind == MESSAGE_ERROR) ? IMASM_ERROR : IMASM_WARNING;
+		diagnostic->lineNum = lineNum;
+		textCopy = (char *)arenaAlloc(&asmCtx->texts, strlen(text) + 1);
+		if (textCopy)
+		{
+			strcpy(textCopy, text);
+		}
+		else
+		{
+			asmCtx->textsFailed = TRUE;
+		}
+		diagnostic->text = textCopy ? textCopy : "";
+	}
+	result->diagnosticsNum++;
+}
+
+/* Copies the memory image, the entries and the externs of the assembled source to the buffers of the result. */
+void addSymbols(assemblyContext *ctx, imasmResult *result, int *memoryArr)
+{
+	int i, wordsNum = (result->IC + result->DC < result->wordsSize) ? result->IC + result->DC : result->wordsSize;
+
+	if (wordsNum > 0)
+	{
+		memcpy(result->words, memoryArr, wordsNum * sizeof(int));
+	}
+
+	result->entriesNum = ctx->entryLabelsNum;
+	for (i = 0; i < ctx->entryLabelsNum; i++)
+	{
+		labelInfo *label = &ctx->labelArr[ctx->entryArr[i].labelInd];
+
+		setSymbol(result->entries, result->entriesSize, i, label->name, label->address);
+	}
+
+	result->externsNum = ctx->externNum;
+	for (i = 0; i < ctx->externNum; i++)
+	{
+		setSymbol(result->externs, result->externsSize, i, ctx->labelArr[ctx->externArr[i].labelInd].name,
+			ctx->externArr[i].address);
+	}
+}
+
+/* Assembles 'sourceSize' chars of 'source' (it isn't changed), and fills the result (see imasmResult). */
+imasmStatus imasmAssemble(imasmContext *asmCtx, const char *source, size_t sourceSize, const imasmOptions *options,
+	imasmResult *result)
+{
+	assemblyContext *ctx = asmCtx->ctx;
+	linesList lines = { 0 };
+	int *memoryArr = NULL, IC = 0, DC = 0, numOfErrors = 0;
+	char *log = NULL;
+	size_t logSize = 0;
+
+	result->IC = result->DC = 0;
+	result->entriesNum = result->externsNum = result->diagnosticsNum = result->errorsNum = 0;
+
+	/* The texts of the last source are freed */
+	arenaReset(&asmCtx->texts);
+	asmCtx->textsFailed = FALSE;
+	asmCtx->result = result;
+	ctx->onMessage = addDiagnostic;
+	ctx->messageData = asmCtx;
+
+	/* The settings of the command line, without the ones which need files or threads */
+	ctx->options.maxWords = options ? options->maxWords : MAX_DATA_NUM;
+	ctx->options.singlePass = (options && options->singlePass) ? TRUE : FALSE;
+	ctx->options.useCache = FALSE;
+	ctx->options.stream = FALSE;
+	ctx->options.stats = FALSE;
+	ctx->options.threadsNum = 1;
+
+	/* The lines are cut in place, so the reads get a copy of the source */
+	ctx->log = open_memstream(&log, &logSize);
+	ctx->source = (char *)arenaAlloc(&ctx->arena, sourceSize + 1);
+	if (ctx->log && ctx->source)
+	{
+		memcpy(ctx->source, source, sourceSize);
+		ctx->source[sourceSize] = '\0';
+
+		numOfErrors += parallelFileRead(ctx, ctx->source, sourceSize, &lines, &IC, &DC);
+		memoryArr = encodeMemoryImage(ctx, &lines, IC, DC, &numOfErrors);
+	}
+
+	if (ctx->log)
+	{
+		fclose(ctx->log);
+	}
+	free(log);
+	ctx->log = stdout;
+	ctx->onMessage = NULL;
+
+	result->errorsNum = numOfErrors;
+	if (memoryArr && numOfErrors == 0)
+	{
+		result->IC = IC;
+		result->DC = DC;
+		addSymbols(ctx, result, memoryArr);
+	}
+	clearData(ctx);
+
+	if (!memoryArr || asmCtx->textsFailed)
+	{
+		return IMASM_NO_MEMORY;
+	}
+	if (numOfErrors)
+	{
+		return IMASM_ERRORS;
+	}
+	return (result->IC + result->DC > result->wordsSize || result->entriesNum > result->entriesSize ||
+		result->externsNum > result->externsSize || result->diagnosticsNum > result->diagnosticsSize) ?
+		IMASM_TRUNCATED : IMASM_OK;
+}
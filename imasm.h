@@ -0,0 +1,86 @@
+/*
+The embeddable assembler library (libimasm.a).
+Assembles a source which is already in memory, and returns the memory image, the entries, the externs and the
+messages in buffers of the caller, without the file system. A tool links the library and calls imasmAssemble for
+every source, instead of running the assembler and reading its output files.
+A context keeps its tables and memory between the sources, so it's best to create one and reuse it. A context is
+used by one thread at a time, but a few threads may assemble with their own contexts at the same time.
+*/
+
+#ifndef IMASM_H
+#define IMASM_H
+
+#include <stddef.h>
+
+/* ========== Macros ========== */
+#define IMASM_FIRST_ADDRESS		100		/* The address of the first memory word */
+#define IMASM_NAME_SIZE			31		/* The size of a label name, with its '\0' */
+
+/* ========== Data Structures ========== */
+
+/* The results of imasmAssemble */
+typedef enum
+{
+	IMASM_OK = 0,				/* The source was assembled, and all the results fit in the buffers */
+	IMASM_ERRORS,				/* The source has errors (see the diagnostics), so there are no memory words */
+	IMASM_TRUNCATED,			/* A buffer was too small: it has only the first items (the numbers are the full sizes) */
+	IMASM_NO_MEMORY				/* malloc failed (the text of a diagnostic may be empty) */
+} imasmStatus;
+
+/* The kinds of messages */
+typedef enum { IMASM_ERROR = 0, IMASM_WARNING } imasmSeverity;
+
+/* An entry label, or an operand word of an extern label (like a line of the .ent or .ext file) */
+typedef struct
+{
+	char name[IMASM_NAME_SIZE];
+	int address;
+} imasmSymbol;
+
+/* An error or a warning (like the messages of the assembler, without "[Error] At line N: ") */
+typedef struct
+{
+	imasmSeverity severity;
+	int lineNum;						/* The line of the source (0 if the message isn't about a line) */
+	const char *text;					/* Kept by the context until its next imasmAssemble or imasmFree */
+} imasmDiagnostic;
+
+/* The settings of an assembly (NULL - the defaults of the assembler) */
+typedef struct
+{
+	int maxWords;						/* Max number of memory words (4096 by default), 0 means no limit */
+	int singlePass;						/* Not 0 to encode the lines while reading them (the results are the same) */
+} imasmOptions;
+
+/* The buffers of the caller, and what imasmAssemble put in them. */
+/* The caller sets the buffers and their sizes (in items); a buffer may be NULL with a size of 0. */
+typedef struct
+{
+	/* Set by the caller */
+	int *words;							/* The memory image: IC command words and then DC data words, 14 bits each */
+	int wordsSize;
+	imasmSymbol *entries;				/* In the order of the .entry lines */
+	int entriesSize;
+	imasmSymbol *externs;				/* In the order of their addresses */
+	int externsSize;
+	imasmDiagnostic *diagnostics;		/* In the order of the lines, like the messages of the assembler */
+	int diagnosticsSize;
+	/* Set by imasmAssemble (the full numbers, even if a buffer was too small) */
+	int IC;
+	int DC;
+	int entriesNum;
+	int externsNum;
+	int diagnosticsNum;
+	int errorsNum;
+} imasmResult;
+
+/* The state of the assembler (opaque) */
+typedef struct imasmContext imasmContext;
+
+/* ======== Methods Declaration ======== */
+imasmContext *imasmCreate(void);
+void imasmFree(imasmContext *asmCtx);
+imasmStatus imasmAssemble(imasmContext *asmCtx, const char *source, size_t sourceSize, const imasmOptions *options,
+	imasmResult *result);
+
+#endif
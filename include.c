@@ -0,0 +1,532 @@
+/*
+This file reads the .include directive: .include "file" adds the macros and the extern labels of another file, like a
+shared header of constants. An included file may only have .define and .extern lines (and comments and empty lines).
+Every included file is parsed once into a module, with its macros and extern labels, which is kept in a cache of the
+whole process (for all the files and threads, see -j, --batch and --serve). While the file keeps its size and
+modification time, including it again only adds the symbols of its module to the context, without parsing its lines.
+The path of an included file is relative to the directory of the source file which includes it.
+The lock of the cache is held only to find, add and remove modules: a file is parsed without it, and a module is
+read-only, so its symbols are added after the lock is released (a reference count keeps it until then).
+The cache keeps up to INCLUDE_CACHE_SIZE modules, and the module which was used least recently is removed first.
+*/
+
+/* ======== Includes ======== */
+#include "assembler.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+/* ====== Data Structures ====== */
+
+/* An error or a warning of parsing an included file */
+typedef struct
+{
+	messageKind kind;
+	int lineNum;					/* The line of the included file (0 if the message isn't about a line) */
+	char *text;						/* Allocated by malloc */
+} moduleMessage;
+
+/* A parsed include file */
+typedef struct includeModule
+{
+	char *path;						/* The path of the file (the key of the cache) */
+	unsigned int hash;				/* The hash of the path (see getNameHash) */
+	struct timespec modTime;		/* The state of the file when it was parsed (if it changes, the file is parsed again) */
+	off_t size;
+	ino_t inode;
+	macro *macroArr;				/* The macros of the .define lines, in their order */
+	int macroNum;
+	labelInfo *externArr;			/* The labels of the .extern lines, in their order */
+	int externNum;
+	int errorsNum;					/* A file with errors can't be included */
+	moduleMessage *messageArr;		/* The messages of parsing the file, in their order (allocated by malloc and grows) */
+	int messagesNum;
+	int messageArrSize;
+	bool messagesFailed;			/* TRUE if a message couldn't be kept (not enough memory) */
+	int refsNum;					/* The .include directives which use the module, and 1 while it's in the cache */
+	unsigned long lastUse;			/* When the module was last found in the cache (see g_includeClock) */
+	struct includeModule *next;		/* The next module in the same slot of the cache */
+} includeModule;
+
+/* The cache of the included files, a chain of modules in every slot by the hash of their path */
+/* (all of it, and the reference counts of the modules, are protected by g_includeLock) */
+includeModule *g_includeSlots[INCLUDE_SLOTS_NUM];
+int g_includeModulesNum = 0;
+unsigned long g_includeClock = 0;
+pthread_mutex_t g_includeLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ====== Methods ====== */
+
+/* Frees a module and all its malloc blocks. */
+void freeIncludeModule(includeModule *module)
+{
+	int i;
+
+	free(module->path);
+	free(module->macroArr);
+	free(module->externArr);
+	for (i = 0; i < module->messagesNum; i++)
+	{
+		free(module->messageArr[i].text);
+	}
+	free(module->messageArr);
+	free(module);
+}
+
+/* Removes a reference to a module, and returns the module if it has no references left (the caller frees it */
+/* after releasing the lock), or NULL. Must be called with g_includeLock. */
+includeModule *dropIncludeRef(includeModule *module)
+{
+	return (--module->refsNum == 0) ? module : NULL;
+}
+
+/* Removes a module from the cache. Returns it if it has to be freed (see dropIncludeRef). */
+/* Must be called with g_includeLock. */
+includeModule *removeIncludeModule(includeModule *module)
+{
+	includeModule **modulePtr = &g_includeSlots[module->hash & (INCLUDE_SLOTS_NUM - 1)];
+
+	while (*modulePtr != module)
+	{
+		modulePtr = &(*modulePtr)->next;
+	}
+	*modulePtr = module->next;
+	module->next = NULL;
+	g_includeModulesNum--;
+	return dropIncludeRef(module);
+}
+
+/* Removes the module which was used least recently from the cache (see removeIncludeModule). */
+/* Must be called with g_includeLock. */
+includeModule *removeOldestModule()
+{
+	includeModule *module, *oldest = NULL;
+	int i;
+
+	for (i = 0; i < INCLUDE_SLOTS_NUM; i++)
+	{
+		for (module = g_includeSlots[i]; module; module = module->next)
+		{
+			if (!oldest || module->lastUse < oldest->lastUse)
+			{
+				oldest = module;
+			}
+		}
+	}
+	return oldest ? removeIncludeModule(oldest) : NULL;
+}
+
+/* Frees all the modules of the cache (no file may be assembled at the same time). */
+void freeIncludeCache()
+{
+	includeModule *module;
+	int i;
+
+	pthread_mutex_lock(&g_includeLock);
+	for (i = 0; i < INCLUDE_SLOTS_NUM; i++)
+	{
+		while (g_includeSlots[i])
+		{
+			module = removeIncludeModule(g_includeSlots[i]);
+			if (module)
+			{
+				freeIncludeModule(module);
+			}
+		}
+	}
+	pthread_mutex_unlock(&g_includeLock);
+}
+
+/* Parses the lines of an included file into the context of its module (like firstFileRead). */
+/* Every line which isn't a .define, an .extern, a comment or an empty line is an error. Returns how many errors were found. */
+int readIncludeLines(assemblyContext *ctx, char *source, size_t sourceSize)
+{
+	char *lineStr = source, *endOfLine, *endOfSource = source + sourceSize;
+	lineInfo line;
+	int errorsFound = 0, lineNum = 0, IC = 0, DC = 0;
+
+	for (; lineStr < endOfSource; lineStr = endOfLine + 1)
+	{
+		endOfLine = (char *)memchr(lineStr, '\n', endOfSource - lineStr);
+		if (!endOfLine)
+		{
+			endOfLine = endOfSource;
+		}
+		*endOfLine = '\0';
+		lineNum++;
+
+		if (endOfLine - lineStr > MAX_LINE_LENGTH)
+		{
+			printError(ctx, lineNum, "Line is too long. Max line length is %d.", MAX_LINE_LENGTH);
+			errorsFound++;
+			continue;
+		}
+
+		scanLine(&ctx->scan, lineStr, endOfLine - lineStr);
+		parseLine(ctx, &line, lineStr, lineNum, &IC, &DC);
+		if (!line.isError && line.commandStr && strcmp(line.commandStr, MACRO_COMMAND) != 0 &&
+			strcmp(line.commandStr, "extern") != 0)
+		{
+			printError(ctx, lineNum, "An included file can only have .define and .extern lines.");
+			line.isError = TRUE;
+		}
+
+		if (line.isError)
+		{
+			errorsFound++;
+		}
+	}
+
+	return errorsFound;
+}
+
+/* Keeps an error or a warning of parsing an included file in its module (see messageHandler). */
+void addModuleMessage(void *data, messageKind kind, int lineNum, const char *text)
+{
+	includeModule *module = (includeModule *)data;
+	moduleMessage *message;
+
+	if (!growArray((void **)&module->messageArr, &module->messageArrSize, module->messagesNum, sizeof(moduleMessage)))
+	{
+		module->messagesFailed = TRUE;
+		return;
+	}
+	message = &module->messageArr[module->messagesNum];
+	message->kind = kind;
+	message->lineNum = lineNum;
+	message->text = (char *)malloc(strlen(text) + 1);
+	if (!message->text)
+	{
+		module->messagesFailed = TRUE;
+		return;
+	}
+	strcpy(message->text, text);
+	module->messagesNum++;
+}
+
+/* Parses an included file into a new module. Returns NULL if the file can't be read or there isn't enough memory. */
+includeModule *parseIncludeModule(char *path, unsigned int hash, struct stat *fileStat)
+{
+	includeModule *module = (includeModule *)calloc(1, sizeof(includeModule));
+	assemblyContext *ctx = createContext();
+	FILE *file = fopen(path, "r");
+	char *source = NULL;
+	size_t sourceSize;
+	bool isDone = FALSE;
+
+	if (module && ctx && file && (module->path = (char *)malloc(strlen(path) + 1)))
+	{
+		strcpy(module->path, path);
+		module->hash = hash;
+		module->modTime = fileStat->st_mtim;
+		module->size = fileStat->st_size;
+		module->inode = fileStat->st_ino;
+
+		/* The messages are only kept in the module (they are printed at every .include of the file), */
+		/* and the module has no includeDir, so an included file can't include other files */
+		ctx->log = NULL;
+		ctx->onMessage = addModuleMessage;
+		ctx->messageData = module;
+		source = readSourceFile(&ctx->arena, file, &sourceSize);
+		if (source)
+		{
+			module->errorsNum = readIncludeLines(ctx, source, sourceSize);
+		}
+		ctx->log = stdout;
+		ctx->onMessage = NULL;
+
+		/* Keep the symbols (only the extern labels are left in labelArr) */
+		module->macroArr = (macro *)malloc((ctx->macroNum + 1) * sizeof(macro));
+		module->externArr = (labelInfo *)malloc((ctx->labelNum + 1) * sizeof(labelInfo));
+		if (source && module->macroArr && module->externArr && !module->messagesFailed)
+		{
+			memcpy(module->macroArr, ctx->macroArr, ctx->macroNum * sizeof(macro));
+			module->macroNum = ctx->macroNum;
+			memcpy(module->externArr, ctx->labelArr, ctx->labelNum * sizeof(labelInfo));
+			module->externNum = ctx->labelNum;
+			isDone = TRUE;
+		}
+	}
+
+	if (file)
+	{
+		fclose(file);
+	}
+	if (ctx)
+	{
+		freeContext(ctx);
+	}
+	if (module && !isDone)
+	{
+		freeIncludeModule(module);
+		module = NULL;
+	}
+	return module;
+}
+
+/* Returns the module of 'path' in the cache (NULL if there isn't). Must be called with g_includeLock. */
+includeModule *findIncludeModule(char *path, unsigned int hash)
+{
+	includeModule *module;
+
+	for (module = g_includeSlots[hash & (INCLUDE_SLOTS_NUM - 1)]; module; module = module->next)
+	{
+		if (module->hash == hash && strcmp(module->path, path) == 0)
+		{
+			return module;
+		}
+	}
+	return NULL;
+}
+
+/* Returns if a module was parsed from the file in its current state. */
+bool isCurrentModule(includeModule *module, struct stat *fileStat)
+{
+	return (module->size == fileStat->st_size && module->inode == fileStat->st_ino &&
+		module->modTime.tv_sec == fileStat->st_mtim.tv_sec && module->modTime.tv_nsec == fileStat->st_mtim.tv_nsec) ?
+		TRUE : FALSE;
+}
+
+/* Adds a reference of the caller to a module of the cache. Must be called with g_includeLock. */
+void useIncludeModule(includeModule *module)
+{
+	module->refsNum++;
+	module->lastUse = ++g_includeClock;
+}
+
+/* Adds a new module to the cache (with the reference of the cache). If the cache is full, the module which was used */
+/* least recently is removed, and returned if it has to be freed (or NULL). Must be called with g_includeLock. */
+includeModule *insertIncludeModule(includeModule *module)
+{
+	includeModule **slot = &g_includeSlots[module->hash & (INCLUDE_SLOTS_NUM - 1)];
+	includeModule *removedModule = NULL;
+
+	if (g_includeModulesNum >= INCLUDE_CACHE_SIZE)
+	{
+		removedModule = removeOldestModule();
+	}
+	module->refsNum = 1;
+	module->next = *slot;
+	*slot = module;
+	g_includeModulesNum++;
+	return removedModule;
+}
+
+/* Returns the module of an included file, with a reference for the caller (see releaseIncludeModule). */
+/* The file is parsed if it isn't in the cache, or if it changed since it was parsed. Returns NULL if the file */
+/* can't be read. The file is parsed without the lock, so a few threads may parse it at once (the first one is kept). */
+includeModule *getIncludeModule(char *path)
+{
+	struct stat fileStat;
+	includeModule *module, *newModule, *oldModule = NULL, *removedModule = NULL;
+	unsigned int hash = getNameHash(path);
+
+	if (stat(path, &fileStat) < 0)
+	{
+		return NULL;
+	}
+
+	pthread_mutex_lock(&g_includeLock);
+	module = findIncludeModule(path, hash);
+	if (module && isCurrentModule(module, &fileStat))
+	{
+		useIncludeModule(module);
+		pthread_mutex_unlock(&g_includeLock);
+		return module;
+	}
+	pthread_mutex_unlock(&g_includeLock);
+
+	/* A new file, or a file which changed */
+	newModule = parseIncludeModule(path, hash, &fileStat);
+	if (!newModule)
+	{
+		return NULL;
+	}
+
+	pthread_mutex_lock(&g_includeLock);
+	module = findIncludeModule(path, hash);
+	if (module && isCurrentModule(module, &fileStat))
+	{
+		/* Another thread added the same file while it was parsed */
+		oldModule = newModule;
+	}
+	else
+	{
+		/* The old module of the file is replaced (it's freed when its last user releases it) */
+		if (module)
+		{
+			oldModule = removeIncludeModule(module);
+		}
+		removedModule = insertIncludeModule(newModule);
+		module = newModule;
+	}
+	useIncludeModule(module);
+	pthread_mutex_unlock(&g_includeLock);
+
+	if (oldModule)
+	{
+		freeIncludeModule(oldModule);
+	}
+	if (removedModule)
+	{
+		freeIncludeModule(removedModule);
+	}
+	return module;
+}
+
+/* Releases the reference of the caller to a module (see getIncludeModule). */
+void releaseIncludeModule(includeModule *module)
+{
+	pthread_mutex_lock(&g_includeLock);
+	module = dropIncludeRef(module);
+	pthread_mutex_unlock(&g_includeLock);
+
+	if (module)
+	{
+		freeIncludeModule(module);
+	}
+}
+
+/* Prints the messages of parsing an included file at the line of the .include directive, */
+/* each with the line of the included file it's about. */
+void printModuleMessages(assemblyContext *ctx, includeModule *module, int lineNum)
+{
+	moduleMessage *message;
+	int i;
+
+	for (i = 0; i < module->messagesNum; i++)
+	{
+		message = &module->messageArr[i];
+		if (message->kind == MESSAGE_ERROR)
+		{
+			printError(ctx, lineNum, "In \"%s\" at line %d: %s", module->path, message->lineNum, message->text);
+		}
+		else
+		{
+			printWarning(ctx, lineNum, "In \"%s\" at line %d: %s", module->path, message->lineNum, message->text);
+		}
+	}
+}
+
+/* Adds the macros and the extern labels of a module to the context, with the same checks as their lines. */
+/* The errors are printed at the line of the .include directive. */
+void addIncludeModule(assemblyContext *ctx, includeModule *module, lineInfo *line)
+{
+	macro mac;
+	labelInfo *label;
+	int i;
+
+	/* Macros (a redefined name keeps its first value, like in addMacroToArray) */
+	for (i = 0; i < module->macroNum; i++)
+	{
+		mac = module->macroArr[i];
+		mac.lineNum = line->lineNum;
+		if (getLabel(ctx, mac.name))
+		{
+			printError(ctx, line->lineNum, "The macro \"%s\" of \"%s\" is already a label.", mac.name, module->path);
+			line->isError = TRUE;
+		}
+		else if (growArray((void **)&ctx->macroArr, &ctx->macroArrSize, ctx->macroNum, sizeof(macro)) &&
+			(getMacro(ctx, mac.name) || addToHashIndex(&ctx->macroIndex, getNameHash(mac.name), ctx->macroNum)))
+		{
+			ctx->macroArr[ctx->macroNum++] = mac;
+		}
+		else
+		{
+			printError(ctx, line->lineNum, "Not enough memory for more macro's.");
+			line->isError = TRUE;
+			return;
+		}
+	}
+
+	/* Extern labels */
+	for (i = 0; i < module->externNum; i++)
+	{
+		label = &module->externArr[i];
+		if (isExistingLabel(ctx, label->name))
+		{
+			printError(ctx, line->lineNum, "The label \"%s\" of \"%s\" already exists.", label->name, module->path);
+			line->isError = TRUE;
+		}
+		else if (isExistingMacro(ctx, label->name))
+		{
+			printError(ctx, line->lineNum, "The label \"%s\" of \"%s\" is already a macro.", label->name, module->path);
+			line->isError = TRUE;
+		}
+		else if (growArray((void **)&ctx->labelArr, &ctx->labelArrSize, ctx->labelNum, sizeof(labelInfo)) &&
+			addToHashIndex(&ctx->labelIndex, getNameHash(label->name), ctx->labelNum))
+		{
+			ctx->labelArr[ctx->labelNum++] = *label;
+		}
+		else
+		{
+			printError(ctx, line->lineNum, "Not enough memory for more labels.");
+			line->isError = TRUE;
+			return;
+		}
+	}
+}
+
+/* Parses a .include directive. */
+void parseIncludeDirc(assemblyContext *ctx, lineInfo *line)
+{
+	includeModule *module;
+	char *name, *path;
+	size_t length;
+
+	/* If there is a label in the line, remove the it from labelArr */
+	if (line->label)
+	{
+		removeLastLabel(ctx, line->lineNum);
+	}
+
+	/* The name of the file is enclosed in quotes */
+	trimStr(&line->lineStr);
+	name = line->lineStr;
+	length = strlen(name);
+	if (length < 3 || name[0] != '"' || name[length - 1] != '"')
+	{
+		printError(ctx, line->lineNum, "The file name of .include must be enclosed in quotes.");
+		line->isError = TRUE;
+		return;
+	}
+	name[length - 1] = '\0';
+	name++;
+
+	if (!ctx->includeDir)
+	{
+		printError(ctx, line->lineNum, "Only source files can include files.");
+		line->isError = TRUE;
+		return;
+	}
+	path = (char *)arenaAlloc(&ctx->arena, strlen(ctx->includeDir) + strlen(name) + 1);
+	if (!path)
+	{
+		printError(ctx, line->lineNum, "Not enough memory to include the file.");
+		line->isError = TRUE;
+		return;
+	}
+	sprintf(path, "%s%s", (name[0] == '/') ? "" : ctx->includeDir, name);
+
+	/* The module is kept while it's used, even if another thread replaces it in the cache */
+	module = getIncludeModule(path);
+	if (!module)
+	{
+		printError(ctx, line->lineNum, "Can't read the included file \"%s\".", path);
+		line->isError = TRUE;
+	}
+	else
+	{
+		if (module->errorsNum)
+		{
+			printError(ctx, line->lineNum, "The included file \"%s\" has errors.", path);
+			line->isError = TRUE;
+		}
+		printModuleMessages(ctx, module, line->lineNum);
+		if (!module->errorsNum)
+		{
+			addIncludeModule(ctx, module, line);
+		}
+		releaseIncludeModule(module);
+	}
+}
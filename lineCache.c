@@ -0,0 +1,440 @@
+/*
+This file keeps the results of parsing and encoding the lines of a file between assemblies (see --cache).
+A line with the same text and the same macros before it is replayed from the .cache file instead of being parsed.
+The label operands of a replayed line are always written by fixups, so the cache never depends on the labels.
+
+The .cache file starts with CACHE_MAGIC, followed by the lines (ints are saved in the byte order of the machine):
+macroHash, textLength, isData, labelLength (-1 if there isn't a label), wordsNum, refsNum,
+the text, the label, the words, and for each ref: wordInd, type, isDest, nameLength, name (the strings end with '\0').
+*/
+
+/* ======== Includes ======== */
+#include "assembler.h"
+#include <stdlib.h>
+
+/* ======== Macros ======== */
+#define CACHE_MAGIC		"IMASM-CACHE 1\n"
+#define CACHE_ENDING	".cache"
+
+/* ====== Data Structures ====== */
+
+/* Reads the .cache file from memory */
+typedef struct
+{
+	char *pos;
+	char *end;
+} cacheReader;
+
+/* ====== Methods ====== */
+
+/* Returns the hash of the text of a line and the state of the macros before it (never 0). */
+unsigned int getLineHash(char *text, int textLength, unsigned int macroHash)
+{
+	unsigned int hash = 2166136261u ^ macroHash;
+	int i;
+
+	for (i = 0; i < textLength; i++)
+	{
+		hash ^= (unsigned char)text[i];
+		hash *= 16777619u;
+	}
+
+	return hash ? hash : 1;
+}
+
+/* Returns the cached line with 'text' and the current macros, or NULL if there isn't one. */
+cachedLine *findCachedLine(assemblyContext *ctx, char *text, int textLength)
+{
+	lineCache *cache = &ctx->cache;
+	unsigned int hash, mask = cache->index.size - 1, i;
+	cachedLine *cached;
+
+	if (!cache->index.count)
+	{
+		return NULL;
+	}
+
+	hash = getLineHash(text, textLength, cache->macroHash);
+	for (i = hash & mask; cache->index.slots[i].hash; i = (i + 1) & mask)
+	{
+		cached = &cache->linesArr[cache->index.slots[i].index];
+		if (cache->index.slots[i].hash == hash && cached->macroHash == cache->macroHash &&
+			cached->textLength == textLength && memcmp(cached->text, text, textLength) == 0)
+		{
+			return cached;
+		}
+	}
+	return NULL;
+}
+
+/* Adds a line to the cache (the data of the line must be in the arena). Returns if it succeeded. */
+bool addCachedLine(assemblyContext *ctx, cachedLine *cached)
+{
+	lineCache *cache = &ctx->cache;
+
+	cached->hash = getLineHash(cached->text, cached->textLength, cached->macroHash);
+	if (!growArray((void **)&cache->linesArr, &cache->linesArrSize, cache->linesNum, sizeof(cachedLine)) ||
+		!addToHashIndex(&cache->index, cached->hash, cache->linesNum))
+	{
+		return FALSE;
+	}
+
+	cache->linesArr[cache->linesNum++] = *cached;
+	return TRUE;
+}
+
+/* Parses the line from the cache instead of the source: adds its label, data or command words and fixups. */
+/* 'line' is only used for the label. Returns "FALSE" if there is an error (like parseLine, the label may exist already). */
+bool replayCachedLine(assemblyContext *ctx, cachedLine *cached, lineInfo *line, int lineNum, int *IC, int *DC)
+{
+	int i;
+
+	memset(line, 0, sizeof(lineInfo));
+	line->lineNum = lineNum;
+	ctx->cache.hitsNum++;
+	if (!cached->isUsed)
+	{
+		cached->isUsed = TRUE;
+		ctx->cache.usedNum++;
+	}
+
+	/* Add the label, the same way findLabel and the data directives do */
+	if (cached->labelName)
+	{
+		labelInfo label = { 0 };
+
+		label.address = FIRST_ADDRESS + (cached->isData ? *DC : *IC);
+		label.isData = cached->isData;
+		line->lineStr = cached->labelName;
+		if (!addLabelToArr(ctx, label, line))
+		{
+			return FALSE;
+		}
+	}
+
+	if (cached->isData)
+	{
+		for (i = 0; i < cached->wordsNum; i++)
+		{
+			if (!addNumberToData(ctx, cached->words[i], IC, DC, lineNum))
+			{
+				/* Not enough memory */
+				return FALSE;
+			}
+		}
+		return TRUE;
+	}
+
+	/* Add the command words, and a fixup for each label operand */
+	if (!growArray((void **)&ctx->codeArr, &ctx->codeArrSize, ctx->codeNum + MAX_LINE_WORDS - 1, sizeof(int)))
+	{
+		printError(ctx, lineNum, "Not enough memory to encode the line.");
+		return FALSE;
+	}
+
+	for (i = 0; i < cached->refsNum; i++)
+	{
+		if (!addFixup(ctx, cached->refs[i].name, -1, cached->refs[i].type, ctx->codeNum + cached->refs[i].wordInd,
+			cached->refs[i].isDest, lineNum))
+		{
+			printError(ctx, lineNum, "Not enough memory to encode the line.");
+			return FALSE;
+		}
+	}
+
+	memcpy(ctx->codeArr + ctx->codeNum, cached->words, cached->wordsNum * sizeof(int));
+	ctx->codeNum += cached->wordsNum;
+	*IC += cached->wordsNum;
+	return TRUE;
+}
+
+/* Keeps the state before parsing a line, so the result can be cached after it (see addToLineCache). */
+/* Returns "FALSE" if the line can't be cached (not enough memory). */
+bool markLineCache(assemblyContext *ctx, lineCacheMark *mark, char *text, int textLength, int DC)
+{
+	mark->textLength = textLength;
+	mark->codeNum = ctx->codeNum;
+	mark->DC = DC;
+	mark->macroNum = ctx->macroNum;
+	mark->messagesNum = ctx->messagesNum;
+
+	mark->text = (char *)arenaAlloc(&ctx->arena, textLength + 1);
+	if (!mark->text)
+	{
+		return FALSE;
+	}
+	memcpy(mark->text, text, textLength);
+	mark->text[textLength] = '\0';
+	return TRUE;
+}
+
+/* Copies 'str' to the arena, or returns NULL if there isn't enough memory. */
+char *copyToArena(assemblyContext *ctx, const char *str)
+{
+	char *copy = (char *)arenaAlloc(&ctx->arena, strlen(str) + 1);
+
+	if (copy)
+	{
+		strcpy(copy, str);
+	}
+	return copy;
+}
+
+/* Adds an operand of a parsed line to the refs of its cached line (if it's a label). */
+void addCachedRef(cachedLine *cached, operandInfo *op, bool isDest, int codeNum)
+{
+	if (op->type == LABEL || op->type == INDEX)
+	{
+		cachedRef *ref = &cached->refs[cached->refsNum++];
+
+		ref->name = op->str;
+		ref->wordInd = op->address - FIRST_ADDRESS - codeNum;
+		ref->type = op->type;
+		ref->isDest = isDest;
+	}
+}
+
+/* Updates the state of the macros after parsing a line, and caches the line if it's a command or data line without errors. */
+void addToLineCache(assemblyContext *ctx, lineCacheMark *mark, lineInfo *line, int DC)
+{
+	cachedLine cached = { 0 };
+	int i;
+
+	/* A new macro changes the parsing of the next lines */
+	for (i = mark->macroNum; i < ctx->macroNum; i++)
+	{
+		char *name = ctx->macroArr[i].name;
+
+		ctx->cache.macroHash = getLineHash(name, strlen(name), ctx->cache.macroHash) ^ (unsigned int)ctx->macroArr[i].value;
+	}
+
+	/* Only lines without any message are cached (the other lines are parsed again) */
+	if (!mark->text || line->isError || ctx->messagesNum != mark->messagesNum || (!line->cmd && DC == mark->DC))
+	{
+		return;
+	}
+
+	cached.macroHash = ctx->cache.macroHash;
+	cached.text = mark->text;
+	cached.textLength = mark->textLength;
+	cached.isData = line->cmd ? FALSE : TRUE;
+	cached.labelName = line->label ? copyToArena(ctx, line->label->name) : NULL;
+	cached.wordsNum = cached.isData ? DC - mark->DC : ctx->codeNum - mark->codeNum;
+	cached.words = (int *)arenaAlloc(&ctx->arena, cached.wordsNum * sizeof(int));
+	cached.refs = (cachedRef *)arenaAlloc(&ctx->arena, 2 * sizeof(cachedRef));
+	if ((line->label && !cached.labelName) || !cached.words || !cached.refs)
+	{
+		return;
+	}
+
+	if (cached.isData)
+	{
+		memcpy(cached.words, ctx->dataArr + mark->DC, cached.wordsNum * sizeof(int));
+	}
+	else
+	{
+		memcpy(cached.words, ctx->codeArr + mark->codeNum, cached.wordsNum * sizeof(int));
+		addCachedRef(&cached, &line->op1, FALSE, mark->codeNum);
+		addCachedRef(&cached, &line->op2, TRUE, mark->codeNum);
+	}
+
+	cached.isUsed = TRUE;
+	if (addCachedLine(ctx, &cached))
+	{
+		ctx->cache.usedNum++;
+		ctx->cache.isChanged = TRUE;
+	}
+}
+
+/* ====== .cache File ====== */
+
+/* Reads an int from the .cache file. Returns "FALSE" if the file ended. */
+bool readCacheInt(cacheReader *reader, int *value)
+{
+	if (reader->end - reader->pos < (long)sizeof(int))
+	{
+		return FALSE;
+	}
+
+	memcpy(value, reader->pos, sizeof(int));
+	reader->pos += sizeof(int);
+	return TRUE;
+}
+
+/* Reads a string of 'length' chars (and a '\0') from the .cache file. Returns NULL if the file ended. */
+char *readCacheStr(cacheReader *reader, int length)
+{
+	char *str = reader->pos;
+
+	if (length < 0 || reader->end - reader->pos <= length || str[length] != '\0')
+	{
+		return NULL;
+	}
+
+	reader->pos += length + 1;
+	return str;
+}
+
+/* Reads a cached line from the .cache file (the line points into the file). Returns "FALSE" if it isn't valid. */
+bool readCachedLine(assemblyContext *ctx, cacheReader *reader, cachedLine *cached)
+{
+	int macroHash, isData, labelLength, i;
+	cachedRef *ref;
+
+	if (!readCacheInt(reader, &macroHash) || !readCacheInt(reader, &cached->textLength) || !readCacheInt(reader, &isData) ||
+		!readCacheInt(reader, &labelLength) || !readCacheInt(reader, &cached->wordsNum) || !readCacheInt(reader, &cached->refsNum))
+	{
+		return FALSE;
+	}
+	cached->macroHash = (unsigned int)macroHash;
+	cached->isData = isData ? TRUE : FALSE;
+	cached->isUsed = FALSE;
+
+	/* The words of a line must fit the checks of replayCachedLine */
+	if (cached->wordsNum < 0 || cached->wordsNum > (cached->isData ? MAX_LINE_LENGTH + 1 : MAX_LINE_WORDS) ||
+		cached->refsNum < 0 || cached->refsNum > (cached->isData ? 0 : 2))
+	{
+		return FALSE;
+	}
+
+	cached->text = readCacheStr(reader, cached->textLength);
+	cached->labelName = (labelLength < 0) ? NULL : readCacheStr(reader, labelLength);
+	if (!cached->text || (labelLength >= 0 && !cached->labelName))
+	{
+		return FALSE;
+	}
+
+	cached->words = (int *)arenaAlloc(&ctx->arena, (cached->wordsNum + 1) * sizeof(int));
+	cached->refs = (cachedRef *)arenaAlloc(&ctx->arena, 2 * sizeof(cachedRef));
+	if (!cached->words || !cached->refs)
+	{
+		return FALSE;
+	}
+
+	for (i = 0; i < cached->wordsNum; i++)
+	{
+		if (!readCacheInt(reader, &cached->words[i]))
+		{
+			return FALSE;
+		}
+	}
+
+	for (i = 0; i < cached->refsNum; i++)
+	{
+		int type, isDest, nameLength;
+
+		ref = &cached->refs[i];
+		if (!readCacheInt(reader, &ref->wordInd) || !readCacheInt(reader, &type) ||
+			!readCacheInt(reader, &isDest) || !readCacheInt(reader, &nameLength) ||
+			!(ref->name = readCacheStr(reader, nameLength)) ||
+			ref->wordInd < 0 || ref->wordInd >= cached->wordsNum || (type != LABEL && type != INDEX))
+		{
+			return FALSE;
+		}
+		ref->type = (opType)type;
+		ref->isDest = isDest ? TRUE : FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Loads the cached lines of the file from its .cache file (if there is one, with the output files). */
+/* A file which isn't valid is ignored, so the lines are just parsed. */
+void loadLineCache(assemblyContext *ctx, char *name)
+{
+	char *cacheName = getOutputName(ctx, name);
+	FILE *file = cacheName ? openFile(ctx, cacheName, CACHE_ENDING, "rb") : NULL;
+	cacheReader reader;
+	cachedLine cached;
+	size_t size;
+
+	if (!file)
+	{
+		return;
+	}
+
+	reader.pos = readSourceFile(&ctx->arena, file, &size);
+	fclose(file);
+	if (!reader.pos || size < strlen(CACHE_MAGIC) || memcmp(reader.pos, CACHE_MAGIC, strlen(CACHE_MAGIC)) != 0)
+	{
+		return;
+	}
+	reader.end = reader.pos + size;
+	reader.pos += strlen(CACHE_MAGIC);
+
+	while (reader.pos < reader.end)
+	{
+		if (!readCachedLine(ctx, &reader, &cached) || !addCachedLine(ctx, &cached))
+		{
+			/* Forget all the lines */
+			ctx->cache.linesNum = 0;
+			clearHashIndex(&ctx->cache.index);
+			return;
+		}
+	}
+}
+
+/* Appends an int to the .cache file output. */
+void appendCacheInt(assemblyContext *ctx, outputBuffer *output, int value)
+{
+	appendOutput(&ctx->arena, output, (char *)&value, sizeof(int));
+}
+
+/* Appends a string and its '\0' to the .cache file output. */
+void appendCacheStr(assemblyContext *ctx, outputBuffer *output, char *str, int length)
+{
+	appendOutput(&ctx->arena, output, str, length + 1);
+}
+
+/* Saves the cached lines to the .cache file of the file. */
+/* Only the lines of the last assembly are saved, so old lines don't pile up. */
+/* The file isn't saved again if it already has exactly these lines. */
+void saveLineCache(assemblyContext *ctx, char *name)
+{
+	outputBuffer output = { 0 };
+	cachedLine *cached;
+	int i, j;
+
+	if (!ctx->cache.isChanged && ctx->cache.usedNum == ctx->cache.linesNum)
+	{
+		return;
+	}
+
+	appendOutputStr(&ctx->arena, &output, CACHE_MAGIC);
+
+	for (i = 0; i < ctx->cache.linesNum; i++)
+	{
+		cached = &ctx->cache.linesArr[i];
+		if (!cached->isUsed)
+		{
+			continue;
+		}
+		appendCacheInt(ctx, &output, (int)cached->macroHash);
+		appendCacheInt(ctx, &output, cached->textLength);
+		appendCacheInt(ctx, &output, cached->isData);
+		appendCacheInt(ctx, &output, cached->labelName ? (int)strlen(cached->labelName) : -1);
+		appendCacheInt(ctx, &output, cached->wordsNum);
+		appendCacheInt(ctx, &output, cached->refsNum);
+		appendCacheStr(ctx, &output, cached->text, cached->textLength);
+		if (cached->labelName)
+		{
+			appendCacheStr(ctx, &output, cached->labelName, strlen(cached->labelName));
+		}
+
+		for (j = 0; j < cached->wordsNum; j++)
+		{
+			appendCacheInt(ctx, &output, cached->words[j]);
+		}
+
+		for (j = 0; j < cached->refsNum; j++)
+		{
+			appendCacheInt(ctx, &output, cached->refs[j].wordInd);
+			appendCacheInt(ctx, &output, cached->refs[j].type);
+			appendCacheInt(ctx, &output, cached->refs[j].isDest);
+			appendCacheInt(ctx, &output, strlen(cached->refs[j].name));
+			appendCacheStr(ctx, &output, cached->refs[j].name, strlen(cached->refs[j].name));
+		}
+	}
+
+	writeOutputFile(ctx, name, CACHE_ENDING, &output);
+}
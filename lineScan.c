@@ -0,0 +1,154 @@
+/*
+This file classifies the chars of a line in one pass, before the line is parsed (see scanLine).
+The scan keeps a bit for every "break" char of the line: a white space, a separator (, : = [ ] ") or '\0'.
+The parser only writes '\0' over break chars, so a search for a separator can jump from break to break
+(see findLineChar) and still stop at the end of the current part of the line, exactly like strchr.
+With SSE2 the line is classified 16 chars at a time, otherwise a char at a time with g_charClass.
+*/
+
+/* ======== Includes ======== */
+#include "assembler.h"
+#if defined(__SSE2__) && !defined(NO_SIMD_SCAN)
+#include <emmintrin.h>
+#define SIMD_SCAN
+#endif
+
+/* ======== Macros ======== */
+#define S	(CHAR_SPACE | CHAR_BREAK)
+#define B	CHAR_BREAK
+
+/* ====== Chars Table ====== */
+
+/* The class of every char (like isspace, but without the locale) */
+const unsigned char g_charClass[256] =
+{
+	B, 0, 0, 0, 0, 0, 0, 0, 0, S, S, S, S, S, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	S, 0, B, 0, 0, 0, 0, 0, 0, 0, 0, 0, B, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, B, 0, 0, B, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, B, 0, B, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+#undef S
+#undef B
+
+/* ====== Methods ====== */
+
+/* Returns the index of the lowest bit which is 1 in mask (mask isn't 0). */
+int getLowestBit(unsigned int mask)
+{
+#ifdef __GNUC__
+	return __builtin_ctz(mask);
+#else
+	int i = 0;
+
+	while (!(mask & 1))
+	{
+		mask >>= 1;
+		i++;
+	}
+	return i;
+#endif
+}
+
+#ifdef SIMD_SCAN
+/* Returns the break bits of 16 chars. */
+unsigned int getBlockBreaks(const char *chars)
+{
+	__m128i block = _mm_loadu_si128((const __m128i *)chars);
+	__m128i breaks;
+
+	/* '\t' to '\r' are the chars which (c - 9) is below 5 (unsigned, so it's compared with the sign bit flipped) */
+	breaks = _mm_cmplt_epi8(_mm_xor_si128(_mm_sub_epi8(block, _mm_set1_epi8(9)), _mm_set1_epi8((char)0x80)),
+		_mm_set1_epi8((char)(5 ^ 0x80)));
+	breaks = _mm_or_si128(breaks, _mm_cmpeq_epi8(block, _mm_set1_epi8(' ')));
+	breaks = _mm_or_si128(breaks, _mm_cmpeq_epi8(block, _mm_set1_epi8(',')));
+	breaks = _mm_or_si128(breaks, _mm_cmpeq_epi8(block, _mm_set1_epi8(':')));
+	breaks = _mm_or_si128(breaks, _mm_cmpeq_epi8(block, _mm_set1_epi8('=')));
+	breaks = _mm_or_si128(breaks, _mm_cmpeq_epi8(block, _mm_set1_epi8('[')));
+	breaks = _mm_or_si128(breaks, _mm_cmpeq_epi8(block, _mm_set1_epi8(']')));
+	breaks = _mm_or_si128(breaks, _mm_cmpeq_epi8(block, _mm_set1_epi8('"')));
+	breaks = _mm_or_si128(breaks, _mm_cmpeq_epi8(block, _mm_setzero_si128()));
+	return (unsigned int)_mm_movemask_epi8(breaks);
+}
+#endif
+
+/* Classifies the chars of a line of 'length' chars (at most MAX_LINE_LENGTH), and keeps its break bits in 'scan'. */
+void scanLine(lineScan *scan, char *line, int length)
+{
+	int i = 0, blockInd;
+
+	scan->start = line;
+	scan->length = length;
+	memset(scan->breaks, 0, sizeof(scan->breaks));
+
+#ifdef SIMD_SCAN
+	/* The whole blocks (the chars after the line may be out of the source, so they aren't read) */
+	for (; i + SCAN_BLOCK_SIZE <= length; i += SCAN_BLOCK_SIZE)
+	{
+		scan->breaks[i / SCAN_BLOCK_SIZE] = getBlockBreaks(line + i);
+	}
+#endif
+
+	/* The rest of the chars */
+	for (; i < length; i++)
+	{
+		if (IS_BREAK_CHAR(line[i]))
+		{
+			blockInd = i / SCAN_BLOCK_SIZE;
+			scan->breaks[blockInd] |= 1u << (i % SCAN_BLOCK_SIZE);
+		}
+	}
+}
+
+/* Returns a pointer to the first 'c' in str, or NULL if there isn't (like strchr). 'c' must be a separator. */
+/* If str is in the scanned line, only its break chars are checked. */
+char *findLineChar(lineScan *scan, char *str, char c)
+{
+	int offset, blockInd;
+	unsigned int mask;
+	char *found;
+
+	if (!scan->start || str < scan->start || str >= scan->start + scan->length)
+	{
+		return strchr(str, c);
+	}
+
+	offset = str - scan->start;
+	blockInd = offset / SCAN_BLOCK_SIZE;
+	mask = scan->breaks[blockInd] & (~0u << (offset % SCAN_BLOCK_SIZE));
+	FOREVER
+	{
+		while (!mask)
+		{
+			/* The end of the line */
+			if (++blockInd >= SCAN_BLOCKS_NUM)
+			{
+				return NULL;
+			}
+			mask = scan->breaks[blockInd];
+		}
+
+		found = scan->start + blockInd * SCAN_BLOCK_SIZE + getLowestBit(mask);
+		if (*found == c)
+		{
+			return found;
+		}
+		if (*found == '\0')
+		{
+			return NULL;
+		}
+		mask &= mask - 1; /* The next break */
+	}
+}
@@ -1,313 +1,482 @@
-/*
-The main file.
-This file manages the assembling process.
-It calls the first and second read methods, and then creates the output files.
-
-*/
-
-/* ======== Includes ======== */
-#include "assembler.h"
-#include <string.h>
-#include <stdarg.h>
-#include <stdlib.h>
-#include <time.h>
-
-/* ====== Global Data Structures ====== */
-/* Labels */
-labelInfo g_labelArr[MAX_LABELS_NUM];
-int g_labelNum = 0;
-/* Entry Lines */
-lineInfo *g_entryLines[MAX_LABELS_NUM]; 
-int g_entryLabelsNum = 0;
-/* Data */
-int g_dataArr[MAX_DATA_NUM];
-/* Macro */
-macro g_macroArr[MAX_LABELS_NUM];
-int macroArrInd;
-
-/* ====== Methods ====== */
-
-/* Prints an error with the line number. */
-void printError(int lineNum, const char *format, ...)
-{
-	va_list args;
-	va_start(args, format);
-	printf("[Error] At line %d: ", lineNum);
-	vprintf(format, args);
-	printf("\n");
-	va_end(args);
-}
-
-/*Returns a pointer to a string representing the binary translation of a memory word*/
-char *Comp2Binary(int num, char *str)
-{
-	char bin_str[MEMORY_WORD_LENGTH + 1];
-	unsigned int i;
-	for (i = 0; i < MEMORY_WORD_LENGTH; i++)
-	{
-		unsigned int mask = 1u << (MEMORY_WORD_LENGTH - 1 - i);
-		bin_str[i] = (num & mask) ? '1' : '0';
-	}
-	bin_str[MEMORY_WORD_LENGTH] = '\0';
-	strcpy(str, bin_str);
-	return str;
-}
-
-/* Prints a number(a memory word) in base 4 special in the file. */
-void fprintfBase4Spcl(FILE *file, int num)
-{
-	int i;
-	char buffer[MEMORY_WORD_LENGTH + 1];
-	char *p = buffer;
-	p = Comp2Binary(num, p); /* translation from base 2 to base 4 spcl char's */
-	
-	for (i = 0; i < strlen(p)-1; i+=2)
-  	{
-		if(p[i] == '0' && p[i+1] == '0')
-			fprintf(file,"*");
-		else if(p[i] == '0' && p[i+1] == '1')
-			fprintf(file,"#");
-		else if(p[i] == '1' && p[i+1] == '0')
-			fprintf(file,"%%");
-		else if(p[i] == '1' && p[i+1] == '1')
-			fprintf(file,"!");
-	}
-}
-
-/* Creates a file (for writing) from a given name and ending, and returns a pointer to it. */
-FILE *openFile(char *name, char *ending, const char *mode)
-{
-	FILE *file;
-	char *mallocStr = (char *)malloc(strlen(name) + strlen(ending) + 1), *fileName = mallocStr;
-	sprintf(fileName, "%s%s", name, ending);
-
-	file = fopen(fileName, mode);
-	free(mallocStr);
-
-	return file;
-}
-
-/* Creates the .obj file, which contains the assembled lines in base 2 wird. */
-void createObjectFile(char *name, int IC, int DC, int *memoryArr)
-{
-	int i;
-
-	FILE *file;
-	file = openFile(name, ".ob", "w");
-	/* Print IC and DC */
-	fprintf(file, "\t\t");
-	fprintf(file, "%d", IC);
-	fprintf(file, "  ");
-	fprintf(file, "%d", DC);
-
-	/* Print all of memoryArr */
-	for (i = 0; i < IC + DC; i++)
-	{
-		fprintf(file, "\n");
-		fprintf(file, "%d", FIRST_ADDRESS + i);
-		fprintf(file, "\t\t");
-		fprintfBase4Spcl(file, memoryArr[i]);
-	}
-	fclose(file);
-}
-
-/* Creates the .ent file, which contains the addresses for the .entry labels. */
-void createEntriesFile(char *name)
-{
-	int i;
-	FILE *file;
-
-	/* Don't create the entries file if there aren't entry lines */
-	if (!g_entryLabelsNum)
-	{
-		return;
-	}
-
-	file = openFile(name, ".ent", "w");
-
-	for (i = 0; i < g_entryLabelsNum; i++)
-	{
-		fprintf(file, "%s\t\t", g_entryLines[i]->lineStr);
-		fprintf(file,"%d", getLabel(g_entryLines[i]->lineStr)->address);
-
-		if (i != g_entryLabelsNum - 1)
-		{
-			fprintf(file, "\n");
-		}
-	}
-
-	fclose(file);
-}
-
-/* Creates the .ext file, which contains the addresses for the extern labels operands. */
-void createExternFile(char *name, lineInfo *linesArr, int linesFound)
-{
-	int i;
-	labelInfo *label;
-	bool firstPrint = TRUE; /* This bool meant to prevent the creation of the file if there aren't any externs */
-	FILE *file = NULL;
-
-	for (i = 0; i < linesFound; i++)
-	{
-
-		
-		/* Check if the 1st operand is extern label, and print it. */
-		if (linesArr[i].cmd && linesArr[i].cmd->numOfParams >= 2 && linesArr[i].op1.type == LABEL)
-		{
-			label = getLabel(linesArr[i].op1.str);
-			if (label && label->isExtern)
-			{
-				if (firstPrint)
-				{
-					/* Create the file only if there is at least 1 extern */
-					file = openFile(name, ".ext", "w");
-				}
-				else
-				{
-					fprintf(file, "\n");
-				}
-
-				fprintf(file, "%s\t\t", label->name);
-				fprintf(file, "%d", linesArr[i].op1.address);
-				
-				firstPrint = FALSE;
-			}
-		}
-
-		/* Check if the 2nd operand is extern label, and print it. */
-		if (linesArr[i].cmd && linesArr[i].cmd->numOfParams >= 1 && linesArr[i].op2.type == LABEL)
-		{
-			label = getLabel(linesArr[i].op2.str);
-			if (label && label->isExtern)
-			{
-				if (firstPrint)
-				{
-					/* Create the file only if there is at least 1 extern */
-					file = openFile(name, ".ext", "w");
-				}
-				else
-				{
-					fprintf(file, "\n");
-				}
-
-				fprintf(file, "%s\t\t", label->name);
-				fprintf(file, "%d",linesArr[i].op2.address);
-				firstPrint = FALSE;
-			}
-		}
-	}
-
-	if (file)
-	{
-		fclose(file);
-	}
-}
-
-/* Resets all the globals and free all the malloc blocks. */
-void clearData(lineInfo *linesArr, int linesFound, int dataCount)
-{
-	int i;
-
-	/* --- Reset Globals --- */
-
-	/* Reset global labels */
-	for (i = 0; i < g_labelNum; i++)
-	{
-		g_labelArr[i].address = 0;
-		g_labelArr[i].isData = 0;
-		g_labelArr[i].isExtern = 0;
-	}
-	g_labelNum = 0;
-	
-	/* Reset global macro */
-	for (i = 0; i < macroArrInd; i++)
-	{
-		g_macroArr[i].lineNum = 0;
-		g_macroArr[i].value = 0;
-	}
-	macroArrInd = 0;
-	
-	/* Reset global entry lines */
-	for (i = 0; i < g_entryLabelsNum; i++)
-	{
-		g_entryLines[i] = NULL;
-	}
-	g_entryLabelsNum = 0;
-
-	/* Reset global data */
-	for (i = 0; i < dataCount; i++)
-	{
-		g_dataArr[i] = 0;
-	}
-
-	/* Free malloc blocks */
-	for (i = 0; i < linesFound; i++)
-	{
-		free(linesArr[i].originalString);
-	}
-}
-
-/* Parsing a file, and creating the output files. */
-void parseFile(char *fileName)
-{
-	FILE *file = openFile(fileName, ".as", "r");
-	lineInfo linesArr[MAX_LINES_NUM];
-	int memoryArr[MAX_DATA_NUM] = { 0 }, IC = 0, DC = 0, numOfErrors = 0, linesFound = 0;
-
-	/* Open File */
-	if (file == NULL)
-	{
-		printf("[Info] Can't open the file \"%s.as\".\n", fileName);
-		return;
-	}
-	printf("[Info] Successfully opened the file \"%s.as\".\n", fileName);
-
-	/* First Read */
-	numOfErrors += firstFileRead(file, linesArr, &linesFound, &IC, &DC);
-	/* Second Read */
-	numOfErrors += secondFileRead(memoryArr, linesArr, linesFound, IC, DC);
-
-	/* Create Output Files */
-	if (numOfErrors == 0)
-	{
-		/* Create all the output files */
-		createObjectFile(fileName, IC, DC, memoryArr);
-		createExternFile(fileName, linesArr, linesFound);
-		createEntriesFile(fileName);
-		printf("[Info] Created output files for the file \"%s.as\".\n", fileName);
-	}
-	else
-	{
-		/* print the number of errors. */
-		printf("[Info] A total of %d error%s found throughout \"%s.as\".\n", numOfErrors, (numOfErrors > 1) ? "s were" : " was", fileName);
-	}
-
-	/* Free all malloc pointers, and reset the globals. */
-	clearData(linesArr, linesFound, IC + DC);
-
-	/* Close File */
-	fclose(file);
-}
-
-/* Main method. Calls the "parsefile" method for each file name in argv. */
-int main(int argc, char *argv[])
-{
-	int i;
-
-	if (argc < 2)
-	{
-		printf("[Info] no file names were observed.\n");
-		return 1;
-	}
-
-	/* initialize random seed for later use */
-	srand((unsigned)time(NULL));
-
-	for (i = 1; i < argc; i++)
-	{
-		parseFile(argv[i]);
-		printf("\n");
-	}
-
-	return 0;
-}
+/*
+The main file.
+The command line of the assembler: it separates the options from the file names, and assembles the files
+one after the other, with a few threads (see -j), or on a server (see --client).
+The assembling of every file is in assembler.c.
+*/
+
+/* ======== Includes ======== */
+#include "assembler.h"
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+/* ====== Data Structures ====== */
+/* The files queue of the parallel assembling (see parseFilesConcurrently) */
+typedef struct
+{
+	char **fileNames;				/* The names of the files to assemble */
+	int filesNum;
+	int nextFile;					/* The index of the next file to assemble */
+	assemblyOptions options;		/* The settings of all the contexts */
+	char *outDir;					/* The directory of the output files (NULL - next to the source files) */
+	FILE **logs;					/* The messages of each file (NULL until the file is assembled) */
+	pthread_mutex_t lock;			/* Protects nextFile and logs */
+	pthread_cond_t fileDone;		/* Signaled every time a file is assembled */
+	assemblyStats totalStats;		/* The statistics of all the files (see --stats) */
+} filesQueue;
+
+/* ====== Methods ====== */
+
+/* A worker thread of parseFilesConcurrently. Assembles files from the queue until it's empty. */
+void *assembleFilesWorker(void *arg)
+{
+	filesQueue *queue = (filesQueue *)arg;
+	assemblyContext *ctx = createContext();
+	int i;
+
+	if (ctx)
+	{
+		ctx->options = queue->options;
+		ctx->outDir = queue->outDir;
+	}
+
+	FOREVER
+	{
+		FILE *log;
+
+		/* Take the next file */
+		pthread_mutex_lock(&queue->lock);
+		i = queue->nextFile++;
+		pthread_mutex_unlock(&queue->lock);
+		if (i >= queue->filesNum)
+		{
+			break;
+		}
+
+		/* Keep the messages of the file aside, so they are printed in order */
+		log = tmpfile();
+		if (!ctx || !log)
+		{
+			fprintf(stderr, "[Error] Not enough memory to assemble \"%s.as\".\n", queue->fileNames[i]);
+			if (log)
+			{
+				fclose(log);
+				log = NULL;
+			}
+		}
+		else
+		{
+			ctx->log = log;
+			parseFile(ctx, queue->fileNames[i]);
+		}
+
+		/* Hand the messages to the main thread */
+		pthread_mutex_lock(&queue->lock);
+		queue->logs[i] = log ? log : stdout; /* stdout means there is nothing to print */
+		pthread_cond_broadcast(&queue->fileDone);
+		pthread_mutex_unlock(&queue->lock);
+	}
+
+	if (ctx)
+	{
+		pthread_mutex_lock(&queue->lock);
+		addStats(&queue->totalStats, &ctx->totalStats);
+		pthread_mutex_unlock(&queue->lock);
+		freeContext(ctx);
+	}
+	return NULL;
+}
+
+/* Assembles the files one after the other with one context, and adds their statistics to 'totalStats'. */
+/* Returns "FALSE" if there isn't enough memory for the context. */
+bool parseFilesSequentially(char **fileNames, int filesNum, assemblyOptions options, char *outDir, assemblyStats *totalStats)
+{
+	assemblyContext *ctx = createContext();
+	int i;
+
+	if (!ctx)
+	{
+		printf("[Error] Not enough memory - malloc falied.\n");
+		return FALSE;
+	}
+	ctx->options = options;
+	ctx->outDir = outDir;
+
+	for (i = 0; i < filesNum; i++)
+	{
+		parseFile(ctx, fileNames[i]);
+		printf("\n");
+	}
+
+	addStats(totalStats, &ctx->totalStats);
+	freeContext(ctx);
+	return TRUE;
+}
+
+/* Assembles the files with 'jobsNum' worker threads (their output files are in outDir if it isn't NULL), */
+/* and adds the statistics of all the files to 'totalStats'. */
+/* The messages of every file are printed after the messages of the files before it, like in a sequential run. */
+void parseFilesConcurrently(char **fileNames, int filesNum, int jobsNum, assemblyOptions options, char *outDir, assemblyStats *totalStats)
+{
+	filesQueue queue;
+	pthread_t *threadsArr = (pthread_t *)malloc(jobsNum * sizeof(pthread_t));
+	int i, threadsNum = 0;
+
+	/* Without the threads and the logs of the files, assemble them one after the other */
+	queue.logs = (FILE **)calloc(filesNum, sizeof(FILE *));
+	if (!threadsArr || !queue.logs)
+	{
+		free(threadsArr);
+		free(queue.logs);
+		parseFilesSequentially(fileNames, filesNum, options, outDir, totalStats);
+		return;
+	}
+
+	queue.fileNames = fileNames;
+	queue.filesNum = filesNum;
+	queue.nextFile = 0;
+	queue.options = options;
+	queue.outDir = outDir;
+	memset(&queue.totalStats, 0, sizeof(assemblyStats));
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_cond_init(&queue.fileDone, NULL);
+
+	for (i = 0; i < jobsNum; i++)
+	{
+		if (pthread_create(&threadsArr[threadsNum], NULL, assembleFilesWorker, &queue) == 0)
+		{
+			threadsNum++;
+		}
+	}
+
+	/* No threads - assemble the files here */
+	if (!threadsNum)
+	{
+		assembleFilesWorker(&queue);
+	}
+
+	/* Print the messages of the files in order, as soon as they are ready */
+	for (i = 0; i < filesNum; i++)
+	{
+		FILE *log;
+
+		pthread_mutex_lock(&queue.lock);
+		while (!queue.logs[i])
+		{
+			pthread_cond_wait(&queue.fileDone, &queue.lock);
+		}
+		log = queue.logs[i];
+		pthread_mutex_unlock(&queue.lock);
+
+		if (log != stdout)
+		{
+			printLog(log, stdout);
+		}
+		printf("\n");
+	}
+
+	for (i = 0; i < threadsNum; i++)
+	{
+		pthread_join(threadsArr[i], NULL);
+	}
+
+	addStats(totalStats, &queue.totalStats);
+	pthread_mutex_destroy(&queue.lock);
+	pthread_cond_destroy(&queue.fileDone);
+	free(queue.logs);
+	free(threadsArr);
+}
+
+/* Adds the file names of a batch manifest to the names array (which grows when needed): a path in every line, */
+/* with or without the ".as" ending (empty lines and lines which start with '#' are skipped). */
+/* The manifest is "-" for stdin. The names are kept in 'arena'. Returns "FALSE" if the manifest can't be read. */
+bool readBatchManifest(memoryArena *arena, char *manifestName, char ***fileNamesPtr, int *filesNum, int *fileNamesSize)
+{
+	FILE *file = (strcmp(manifestName, "-") == 0) ? stdin : fopen(manifestName, "r");
+	char *text, *line, *end;
+	size_t size, length;
+
+	if (!file)
+	{
+		return FALSE;
+	}
+	text = readSourceFile(arena, file, &size);
+	if (file != stdin)
+	{
+		fclose(file);
+	}
+	if (!text)
+	{
+		return FALSE;
+	}
+
+	for (line = text; line < text + size; line = end + 1)
+	{
+		end = (char *)memchr(line, '\n', text + size - line);
+		end = end ? end : text + size;
+		*end = '\0';
+
+		/* Cut the white spaces around the path (and the '\r' of CRLF lines) */
+		while (IS_SPACE_CHAR(*line))
+		{
+			line++;
+		}
+		for (length = end - line; length && IS_SPACE_CHAR(line[length - 1]); length--)
+		{
+			line[length - 1] = '\0';
+		}
+		if (length == 0 || *line == '#')
+		{
+			continue;
+		}
+
+		if (length > 3 && strcmp(line + length - 3, ".as") == 0)
+		{
+			line[length - 3] = '\0';
+		}
+		if (!growArray((void **)fileNamesPtr, fileNamesSize, *filesNum, sizeof(char *)))
+		{
+			return FALSE;
+		}
+		(*fileNamesPtr)[(*filesNum)++] = line;
+	}
+
+	return TRUE;
+}
+
+/* Prints the summary of a batch: the files which were assembled, the files with errors and the files which weren't read. */
+void printBatchSummary(int filesNum, assemblyStats *totalStats, double wallTime)
+{
+	printf("[Info] A batch of %d file%s: %ld assembled, %ld with errors, %ld not read, in %.3f seconds.\n",
+		filesNum, (filesNum == 1) ? "" : "s", totalStats->filesNum - totalStats->failedNum, totalStats->failedNum,
+		filesNum - totalStats->filesNum, wallTime);
+}
+
+/* Main method. Calls the "parsefile" method for each file name in argv. */
+/* Usage: main [-j N] [--threads N] [--max-words N] [--single-pass] [--cache] [--stream] [--format=text|bin|both] [--stats] */
+/*        [--out-dir DIR] [--batch FILE|-] file1 file2 ... */
+/*        main [-j N] [options] --serve SOCKET */
+/*        main [options] --client SOCKET [--inline] file1 file2 ... */
+/* -j assembles N files at the same time, --threads reads each file with N threads (in the two pass mode), */
+/* --max-words limits the memory of each file (0 - no limit), */
+/* --single-pass encodes the lines while reading them, --cache reuses the lines that didn't change since */
+/* the last assembly of the file (it's single pass too), --stream reads, parses and encodes in three threads */
+/* (single pass, without the cache). The output is always the same. */
+/* --format chooses between the .ob/.ent/.ext text files and the .bin file (see createBinaryFile). */
+/* --stats prints the time of every phase and the counters of every file, and their total (see printStats). */
+/* --serve runs a server on a Unix domain socket, with -j workers (SERVE_JOBS_NUM without -j), and --client sends */
+/* the files to it, with the sources if --inline is given (see serve.c). The client prints the same messages. */
+/* --batch adds the file names in a manifest file (or stdin for -), and prints a summary at the end. */
+/* --out-dir creates the output files in a directory (it's made if it doesn't exist), instead of next to the sources. */
+int main(int argc, char *argv[])
+{
+	int i, filesNum = 0, fileNamesSize = argc, jobsNum = 0, exitCode = 0;
+	char *servePath = NULL, *clientPath = NULL, *batchName = NULL, *outDir = NULL;
+	bool sendSource = FALSE;
+	assemblyOptions options = { MAX_DATA_NUM, FALSE, FALSE, FORMAT_TEXT, FALSE, FALSE, 1 };
+	assemblyStats totalStats;
+	memoryArena batchArena = { 0 };
+	double start;
+	char **fileNames = (char **)malloc(argc * sizeof(char *));
+
+	if (!fileNames)
+	{
+		printf("[Error] Not enough memory - malloc falied.\n");
+		return 1;
+	}
+
+	/* Separate the options from the file names */
+	for (i = 1; i < argc; i++)
+	{
+		if (strncmp(argv[i], "-j", 2) == 0)
+		{
+			char *jobsStr = argv[i][2] ? &argv[i][2] : argv[++i];
+
+			jobsNum = jobsStr ? atoi(jobsStr) : 0;
+			if (jobsNum < 1)
+			{
+				printf("[Info] -j needs a positive number of jobs.\n");
+				free(fileNames);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--threads") == 0)
+		{
+			char *threadsStr = argv[++i];
+
+			options.threadsNum = threadsStr ? atoi(threadsStr) : 0;
+			if (options.threadsNum < 1)
+			{
+				printf("[Info] --threads needs a positive number of threads.\n");
+				free(fileNames);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--max-words") == 0)
+		{
+			char *wordsStr = argv[++i];
+
+			options.maxWords = wordsStr ? atoi(wordsStr) : -1;
+			if (options.maxWords < 0)
+			{
+				printf("[Info] --max-words needs a number of words (0 for no limit).\n");
+				free(fileNames);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--single-pass") == 0)
+		{
+			options.singlePass = TRUE;
+		}
+		else if (strncmp(argv[i], "--format=", 9) == 0)
+		{
+			if (strcmp(argv[i] + 9, "text") == 0)
+			{
+				options.format = FORMAT_TEXT;
+			}
+			else if (strcmp(argv[i] + 9, "bin") == 0)
+			{
+				options.format = FORMAT_BIN;
+			}
+			else if (strcmp(argv[i] + 9, "both") == 0)
+			{
+				options.format = FORMAT_BOTH;
+			}
+			else
+			{
+				printf("[Info] --format must be text, bin or both.\n");
+				free(fileNames);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--stats") == 0)
+		{
+			options.stats = TRUE;
+		}
+		else if (strcmp(argv[i], "--cache") == 0)
+		{
+			options.singlePass = TRUE;
+			options.useCache = TRUE;
+		}
+		else if (strcmp(argv[i], "--stream") == 0)
+		{
+			options.singlePass = TRUE;
+			options.stream = TRUE;
+		}
+		else if (strcmp(argv[i], "--serve") == 0 || strcmp(argv[i], "--client") == 0)
+		{
+			char **pathPtr = (argv[i][2] == 's') ? &servePath : &clientPath;
+
+			*pathPtr = argv[++i];
+			if (!*pathPtr)
+			{
+				printf("[Info] %s needs the path of a socket.\n", argv[i - 1]);
+				free(fileNames);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--inline") == 0)
+		{
+			sendSource = TRUE;
+		}
+		else if (strcmp(argv[i], "--batch") == 0 || strcmp(argv[i], "--out-dir") == 0)
+		{
+			char **valuePtr = (argv[i][2] == 'b') ? &batchName : &outDir;
+
+			*valuePtr = argv[++i];
+			if (!*valuePtr)
+			{
+				printf("[Info] %s needs a %s.\n", argv[i - 1], (valuePtr == &batchName) ? "file name (or -)" : "directory");
+				free(fileNames);
+				return 1;
+			}
+		}
+		else
+		{
+			fileNames[filesNum++] = argv[i];
+		}
+	}
+
+	/* The cached lines are replayed into the code, which only the encoder writes in stream mode */
+	if (options.stream)
+	{
+		options.useCache = FALSE;
+	}
+
+	/* The table is only read while assembling, so it's filled before the threads start */
+	initBase4Table();
+
+	/* The server gets the file names from its clients */
+	if (servePath)
+	{
+		free(fileNames);
+		exitCode = serveAssembler(servePath, jobsNum ? jobsNum : SERVE_JOBS_NUM, options);
+		freeIncludeCache();
+		return exitCode;
+	}
+
+	/* The names of a batch are after the names in the command line */
+	if (batchName && !readBatchManifest(&batchArena, batchName, &fileNames, &filesNum, &fileNamesSize))
+	{
+		printf("[Info] Can't read the batch file \"%s\".\n", batchName);
+		arenaFree(&batchArena);
+		free(fileNames);
+		return 1;
+	}
+
+	if (filesNum < 1 && !batchName)
+	{
+		printf("[Info] no file names were observed.\n");
+		free(fileNames);
+		return 1;
+	}
+
+	/* The output directory is made if it doesn't exist */
+	if (outDir && mkdir(outDir, 0777) < 0 && errno != EEXIST)
+	{
+		printf("[Info] Can't create the output directory \"%s\".\n", outDir);
+		arenaFree(&batchArena);
+		free(fileNames);
+		return 1;
+	}
+
+	/* initialize random seed for later use */
+	srand((unsigned)time(NULL));
+
+	memset(&totalStats, 0, sizeof(assemblyStats));
+	start = (options.stats || batchName) ? getWallTime() : 0;
+
+	if (clientPath)
+	{
+		exitCode = runClient(clientPath, fileNames, filesNum, options, outDir, sendSource, &totalStats);
+	}
+	else if (jobsNum > 1 && filesNum > 1)
+	{
+		parseFilesConcurrently(fileNames, filesNum, (jobsNum < filesNum) ? jobsNum : filesNum, options, outDir, &totalStats);
+	}
+	else if (!parseFilesSequentially(fileNames, filesNum, options, outDir, &totalStats))
+	{
+		arenaFree(&batchArena);
+		free(fileNames);
+		return 1;
+	}
+
+	/* The statistics and the summary of all the files */
+	if (options.stats && !exitCode)
+	{
+		printStats(stdout, "*", &totalStats, getWallTime() - start);
+	}
+	if (batchName && !exitCode)
+	{
+		printBatchSummary(filesNum, &totalStats, getWallTime() - start);
+	}
+
+	freeIncludeCache();
+	arenaFree(&batchArena);
+	free(fileNames);
+	return exitCode;
+}
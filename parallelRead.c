@@ -0,0 +1,600 @@
+/*
+This file reads a file with a few threads (see --threads).
+The first lines of the file (where the macros and the extern labels usually are) are read by the thread of the file,
+and the rest of the source is cut into chunks of whole lines. The first chunk is read by the thread of the file too,
+like in a sequential read. Every other chunk is read on its own by a worker thread, into its own context, which starts
+with the symbols of the first lines and with IC and DC of 0. Then the chunks are joined in order: the addresses are
+moved by the IC and DC of the chunks before them, and the labels, macros, entries, data, instructions, lines and
+messages are added to the context of the file.
+
+A chunk is read the same way as in a sequential read, unless it looked up a name which was added after the first lines
+by the chunks before it (a macro, a label or an entry), or it got to the memory limit. Every chunk keeps the hashes of
+the names it looked up, so this is checked when it's joined. A chunk which fails the check is read again by the thread
+of the file, after the chunks before it were joined, so the result and the messages are always the same as the
+sequential read.
+
+The second read is done by a few threads too. When the first read is done, every instruction has the word it starts at
+and all the addresses of the labels are known, so the instructions don't depend on each other. They are cut into
+ranges, and every range is encoded by a worker thread into its own part of the memory image. A worker uses a copy of
+the context of the file, with its own messages and extern uses, which are added to the file in the order of the ranges.
+*/
+
+/* ======== Includes ======== */
+#include "assembler.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+/* ======== Macros ======== */
+#define FIRST_LINES_NUM		LINES_CHUNK_SIZE	/* The lines which are read before the chunks (whole chunks of the lines list) */
+
+/* ====== Data Structures ====== */
+
+/* A chunk of the file */
+typedef struct
+{
+	assemblyContext *ctx;			/* The context the chunk is read into (kept for the next files) */
+	char *text;						/* The chunk in the source */
+	char *copy;						/* The copy of the chunk the worker thread reads (in the arena of its context) */
+	size_t size;
+	int linesNum;					/* The number of lines in the chunk */
+	linesList lines;				/* The lines of the chunk (in the arena of its context) */
+	int IC;
+	int DC;
+	int errorsNum;
+	bool hasThread;					/* TRUE if a worker thread reads the chunk */
+	pthread_t thread;
+} fileChunk;
+
+/* A range of instructions of the parallel second read */
+typedef struct
+{
+	assemblyContext ctx;			/* A copy of the context of the file, with its own log, extern uses and stats */
+	int *memoryArr;
+	int memorySize;
+	linesList *lines;
+	int firstInstr;
+	int lastInstr;					/* Not included */
+	int errorsNum;
+	bool hasThread;					/* TRUE if a worker thread encodes the range */
+	pthread_t thread;
+} instrRange;
+
+/* The chunks of the parallel read of a file */
+struct parallelState
+{
+	fileChunk *chunksArr;			/* Allocated by malloc, with the contexts of (threadsNum - 1) chunks */
+	instrRange *rangesArr;			/* Allocated by malloc, threadsNum ranges */
+	int threadsNum;					/* The threads the state was made for (the options may change between files, see --serve) */
+	int chunksNum;					/* The number of chunks of the current file */
+	int contextsNum;				/* The number of chunks with a context */
+	/* The symbols of the first lines, which every chunk starts with */
+	int firstLabelsNum;
+	int firstMacrosNum;
+	int firstEntriesNum;
+};
+
+/* ====== Methods ====== */
+
+/* Returns a pointer to the char after 'linesNum' lines from str (or 'end' if there are fewer lines). */
+char *skipLines(char *str, char *end, long linesNum)
+{
+	for (; linesNum > 0 && str < end; linesNum--)
+	{
+		str = (char *)memchr(str, '\n', end - str);
+		str = str ? str + 1 : end;
+	}
+	return str;
+}
+
+/* Returns the number of lines from str to 'end' (the last line may end without '\n', like in firstFileRead). */
+long countSourceLines(char *str, char *end)
+{
+	long linesNum = 0;
+
+	while (str < end)
+	{
+		str = skipLines(str, end, 1);
+		linesNum++;
+	}
+	return linesNum;
+}
+
+/* Returns the parallel state of the context (or NULL if there is no memory), with a context for every worker thread. */
+/* The state is made again if the number of threads changed since the last file. */
+parallelState *getParallelState(assemblyContext *ctx)
+{
+	parallelState *par = ctx->parallel;
+	fileChunk *chunk;
+
+	if (par && par->threadsNum == ctx->options.threadsNum)
+	{
+		return par;
+	}
+	freeParallelRead(ctx);
+
+	par = (parallelState *)calloc(1, sizeof(parallelState));
+	if (!par || !(par->chunksArr = (fileChunk *)calloc(ctx->options.threadsNum, sizeof(fileChunk))) ||
+		!(par->rangesArr = (instrRange *)calloc(ctx->options.threadsNum, sizeof(instrRange))))
+	{
+		if (par)
+		{
+			free(par->chunksArr);
+		}
+		free(par);
+		return NULL;
+	}
+
+	par->threadsNum = ctx->options.threadsNum;
+
+	/* The first chunk is read into the context of the file */
+	for (par->contextsNum = 1; par->contextsNum < ctx->options.threadsNum; par->contextsNum++)
+	{
+		chunk = &par->chunksArr[par->contextsNum];
+		chunk->ctx = createContext();
+		if (!chunk->ctx)
+		{
+			break;
+		}
+		chunk->ctx->options = ctx->options;
+		chunk->ctx->keepLookups = TRUE;
+	}
+
+	ctx->parallel = par;
+	return par;
+}
+
+/* Cuts the source into the chunks of the parallel state. Returns the number of chunks. */
+/* Every chunk but the last has whole chunks of the lines list, so the lines lists of the chunks can be joined. */
+int cutSource(parallelState *par, char *source, size_t sourceSize)
+{
+	char *str = source, *end = source + sourceSize;
+	long linesNum = countSourceLines(source, end), chunkLines;
+	fileChunk *chunk;
+
+	/* The chunks have at least MIN_CHUNK_LINES lines, in whole LINES_CHUNK_SIZE blocks */
+	chunkLines = (linesNum + par->contextsNum - 1) / par->contextsNum;
+	if (chunkLines < MIN_CHUNK_LINES)
+	{
+		chunkLines = MIN_CHUNK_LINES;
+	}
+	chunkLines = (chunkLines + LINES_CHUNK_SIZE - 1) / LINES_CHUNK_SIZE * LINES_CHUNK_SIZE;
+
+	for (par->chunksNum = 0; str < end && par->chunksNum < par->contextsNum; par->chunksNum++)
+	{
+		chunk = &par->chunksArr[par->chunksNum];
+		chunk->text = str;
+		str = (par->chunksNum == par->contextsNum - 1) ? end : skipLines(str, end, chunkLines);
+		chunk->size = str - chunk->text;
+		chunk->linesNum = (int)((linesNum < chunkLines) ? linesNum : chunkLines);
+		linesNum -= chunk->linesNum;
+	}
+	return par->chunksNum;
+}
+
+/* Copies the symbols of the file (the symbols of its first lines) to the context of a chunk. */
+/* Returns "FALSE" if there is no memory. */
+bool copyFirstSymbols(assemblyContext *chunkCtx, assemblyContext *ctx)
+{
+	if (!growArray((void **)&chunkCtx->labelArr, &chunkCtx->labelArrSize, ctx->labelNum, sizeof(labelInfo)) ||
+		!growArray((void **)&chunkCtx->macroArr, &chunkCtx->macroArrSize, ctx->macroNum, sizeof(macro)) ||
+		!growArray((void **)&chunkCtx->entryArr, &chunkCtx->entryArrSize, ctx->entryLabelsNum, sizeof(entryLabel)) ||
+		!copyHashIndex(&chunkCtx->labelIndex, &ctx->labelIndex) || !copyHashIndex(&chunkCtx->macroIndex, &ctx->macroIndex) ||
+		!copyHashIndex(&chunkCtx->entryIndex, &ctx->entryIndex))
+	{
+		return FALSE;
+	}
+
+	chunkCtx->labelNum = ctx->labelNum;
+	chunkCtx->macroNum = ctx->macroNum;
+	chunkCtx->entryLabelsNum = ctx->entryLabelsNum;
+	if (ctx->labelNum)
+	{
+		memcpy(chunkCtx->labelArr, ctx->labelArr, ctx->labelNum * sizeof(labelInfo));
+	}
+	if (ctx->macroNum)
+	{
+		memcpy(chunkCtx->macroArr, ctx->macroArr, ctx->macroNum * sizeof(macro));
+	}
+	if (ctx->entryLabelsNum)
+	{
+		memcpy(chunkCtx->entryArr, ctx->entryArr, ctx->entryLabelsNum * sizeof(entryLabel));
+	}
+	return TRUE;
+}
+
+/* A worker thread. Reads a copy of a chunk into its own context. */
+void *readChunkWorker(void *arg)
+{
+	fileChunk *chunk = (fileChunk *)arg;
+
+	chunk->errorsNum = firstFileRead(chunk->ctx, chunk->copy, chunk->size, &chunk->lines, &chunk->IC, &chunk->DC);
+	return NULL;
+}
+
+/* Starts the worker thread of a chunk, with the symbols of the file. The first line of the chunk is the line after 'firstLine'. */
+/* The worker reads a copy of the chunk, so the source stays as it was (and the chunk can be read again). */
+/* Returns "FALSE" if the thread didn't start. */
+bool startChunk(assemblyContext *fileCtx, fileChunk *chunk, int firstLine)
+{
+	assemblyContext *ctx = chunk->ctx;
+
+	chunk->hasThread = FALSE;
+	ctx->options = fileCtx->options;
+	ctx->includeDir = fileCtx->includeDir;
+	chunk->copy = (char *)arenaAlloc(&ctx->arena, chunk->size + 1);
+	ctx->log = tmpfile();
+	if (!chunk->copy || !ctx->log || !copyFirstSymbols(ctx, fileCtx))
+	{
+		return FALSE;
+	}
+	memcpy(chunk->copy, chunk->text, chunk->size);
+	chunk->copy[chunk->size] = '\0';
+
+	memset(&chunk->lines, 0, sizeof(linesList));
+	chunk->lines.lineNumOffset = firstLine;
+	chunk->IC = 0;
+	chunk->DC = 0;
+	chunk->hasThread = (pthread_create(&chunk->thread, NULL, readChunkWorker, chunk) == 0) ? TRUE : FALSE;
+	return chunk->hasThread;
+}
+
+/* Returns if a chunk which was read on its own got the same result as a sequential read after 'wordsNum' memory words. */
+bool isChunkValid(assemblyContext *ctx, parallelState *par, fileChunk *chunk, int wordsNum)
+{
+	assemblyContext *chunkCtx = chunk->ctx;
+	symbolLookup *lookup;
+	int i;
+
+	/* The chunk stopped before its end, or it's over the memory limit of the whole file */
+	if (chunkCtx->lookupsFailed || chunk->lines.linesNum != chunk->linesNum ||
+		!isBelowMemoryLimit(ctx, wordsNum + chunk->IC + chunk->DC))
+	{
+		return FALSE;
+	}
+
+	/* A name which the chunks before it added (after the first lines) */
+	for (i = 0; i < chunkCtx->lookupNum; i++)
+	{
+		lookup = &chunkCtx->lookupArr[i];
+		if ((lookup->kind == LOOKUP_LABEL && isHashInIndex(&ctx->labelIndex, lookup->hash, par->firstLabelsNum)) ||
+			(lookup->kind == LOOKUP_MACRO && isHashInIndex(&ctx->macroIndex, lookup->hash, par->firstMacrosNum)) ||
+			(lookup->kind == LOOKUP_ENTRY && isHashInIndex(&ctx->entryIndex, lookup->hash, par->firstEntriesNum)))
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/* Adds the labels, macros and entries of a chunk (without the symbols of the first lines) to the context of the file. */
+/* The addresses of the labels are moved by IC and DC of the chunks before it. Returns "FALSE" if there is no memory. */
+bool joinChunkSymbols(assemblyContext *ctx, parallelState *par, assemblyContext *chunkCtx, int IC, int DC)
+{
+	labelInfo label;
+	macro *mac;
+	int i;
+
+	/* Labels (the names are new, since the chunk didn't find them in the chunks before it) */
+	for (i = par->firstLabelsNum; i < chunkCtx->labelNum; i++)
+	{
+		label = chunkCtx->labelArr[i];
+		if (!label.isExtern)
+		{
+			label.address += label.isData ? DC : IC;
+		}
+		if (!growArray((void **)&ctx->labelArr, &ctx->labelArrSize, ctx->labelNum, sizeof(labelInfo)) ||
+			!addToHashIndex(&ctx->labelIndex, getNameHash(label.name), ctx->labelNum))
+		{
+			return FALSE;
+		}
+		ctx->labelArr[ctx->labelNum++] = label;
+	}
+
+	/* Macros (a redefined name keeps its first value, like in addMacroToArray) */
+	for (i = par->firstMacrosNum; i < chunkCtx->macroNum; i++)
+	{
+		mac = &chunkCtx->macroArr[i];
+		if (!growArray((void **)&ctx->macroArr, &ctx->macroArrSize, ctx->macroNum, sizeof(macro)) ||
+			(!getMacro(ctx, mac->name) && !addToHashIndex(&ctx->macroIndex, getNameHash(mac->name), ctx->macroNum)))
+		{
+			return FALSE;
+		}
+		ctx->macroArr[ctx->macroNum++] = *mac;
+	}
+
+	/* Entries */
+	for (i = par->firstEntriesNum; i < chunkCtx->entryLabelsNum; i++)
+	{
+		if (!growArray((void **)&ctx->entryArr, &ctx->entryArrSize, ctx->entryLabelsNum, sizeof(entryLabel)) ||
+			!addToHashIndex(&ctx->entryIndex, getNameHash(chunkCtx->entryArr[i].name), ctx->entryLabelsNum))
+		{
+			return FALSE;
+		}
+		ctx->entryArr[ctx->entryLabelsNum++] = chunkCtx->entryArr[i];
+	}
+
+	return TRUE;
+}
+
+/* Adds a chunk which was read on its own to the file: its symbols, instructions, data, lines and messages. */
+/* Returns "FALSE" if there is no memory. */
+bool joinChunk(assemblyContext *ctx, parallelState *par, fileChunk *chunk, linesList *lines, int *IC, int *DC)
+{
+	assemblyContext *chunkCtx = chunk->ctx;
+	instruction *instr;
+	int i;
+
+	if (!joinChunkSymbols(ctx, par, chunkCtx, *IC, *DC) ||
+		!growArray((void **)&ctx->instrArr, &ctx->instrArrSize, ctx->instrNum + chunkCtx->instrNum, sizeof(instruction)) ||
+		!growArray((void **)&ctx->dataArr, &ctx->dataArrSize, *DC + chunk->DC, sizeof(int)))
+	{
+		return FALSE;
+	}
+
+	/* The instructions (their lines and words are after the lines and words of the file) */
+	for (i = 0; i < chunkCtx->instrNum; i++)
+	{
+		instr = &ctx->instrArr[ctx->instrNum++];
+		*instr = chunkCtx->instrArr[i];
+		instr->lineInd += lines->linesNum;
+		instr->wordInd += *IC;
+	}
+
+	/* The data, and the lines (they keep their addresses in the chunk, only the instructions use them) */
+	if (chunk->DC)
+	{
+		memcpy(ctx->dataArr + *DC, chunkCtx->dataArr, chunk->DC * sizeof(int));
+	}
+	if (!joinLines(&ctx->arena, lines, &chunk->lines))
+	{
+		return FALSE;
+	}
+	*IC += chunk->IC;
+	*DC += chunk->DC;
+
+	ctx->stats.linesNum += chunkCtx->stats.linesNum;
+	ctx->stats.lookupsNum += chunkCtx->stats.lookupsNum;
+	ctx->messagesNum += chunkCtx->messagesNum;
+	return TRUE;
+}
+
+/* Reading the source for the first time with up to ctx->options.threadsNum threads (see firstFileRead). */
+/* In single pass mode, or if the source is too small to cut, it's read by firstFileRead. */
+/* Returns how many errors were found (the lines and the messages are the same as firstFileRead's). */
+int parallelFileRead(assemblyContext *ctx, char *source, size_t sourceSize, linesList *lines, int *IC, int *DC)
+{
+	parallelState *par;
+	fileChunk *chunk;
+	char *endOfFirstLines = skipLines(source, source + sourceSize, FIRST_LINES_NUM);
+	int errorsFound, i, firstLine = FIRST_LINES_NUM;
+	bool isMemoryFull;
+
+	/* The chunks are read into the code and the line cache of their own contexts */
+	if (ctx->options.threadsNum < 2 || ctx->options.singlePass || !(par = getParallelState(ctx)) ||
+		cutSource(par, endOfFirstLines, source + sourceSize - endOfFirstLines) < 2)
+	{
+		return firstFileRead(ctx, source, sourceSize, lines, IC, DC);
+	}
+
+	/* Read the first lines, and start the chunks after the first one with their symbols */
+	errorsFound = firstFileRead(ctx, source, endOfFirstLines - source, lines, IC, DC);
+	if (!isBelowMemoryLimit(ctx, *IC + *DC))
+	{
+		return errorsFound;
+	}
+	par->firstLabelsNum = ctx->labelNum;
+	par->firstMacrosNum = ctx->macroNum;
+	par->firstEntriesNum = ctx->entryLabelsNum;
+	for (i = 1; i < par->chunksNum; i++)
+	{
+		firstLine += par->chunksArr[i - 1].linesNum;
+		startChunk(ctx, &par->chunksArr[i], firstLine);
+	}
+
+	/* The first chunk is read here, like in a sequential read */
+	errorsFound += firstFileRead(ctx, par->chunksArr[0].text, par->chunksArr[0].size, lines, IC, DC);
+	isMemoryFull = !isBelowMemoryLimit(ctx, *IC + *DC);
+
+	/* Join the chunks in order (or read them again), until the memory is full */
+	for (i = 1; i < par->chunksNum; i++)
+	{
+		chunk = &par->chunksArr[i];
+		if (chunk->hasThread)
+		{
+			pthread_join(chunk->thread, NULL);
+		}
+
+		if (!isMemoryFull)
+		{
+			if (chunk->hasThread && isChunkValid(ctx, par, chunk, *IC + *DC))
+			{
+				if (joinChunk(ctx, par, chunk, lines, IC, DC))
+				{
+					errorsFound += chunk->errorsNum;
+					printLog(chunk->ctx->log, ctx->log);
+					chunk->ctx->log = NULL;
+				}
+				else
+				{
+					printError(ctx, 0, "Not enough memory for more lines. Stoping to read the file.");
+					errorsFound++;
+					isMemoryFull = TRUE;
+				}
+			}
+			else
+			{
+				errorsFound += firstFileRead(ctx, chunk->text, chunk->size, lines, IC, DC);
+			}
+			isMemoryFull = isMemoryFull || !isBelowMemoryLimit(ctx, *IC + *DC);
+		}
+
+		if (chunk->ctx->log)
+		{
+			fclose(chunk->ctx->log);
+			chunk->ctx->log = NULL;
+		}
+	}
+
+	return errorsFound;
+}
+
+/* Resets the contexts of the chunks for the next file. */
+void clearParallelRead(assemblyContext *ctx)
+{
+	parallelState *par = ctx->parallel;
+	int i;
+
+	if (!par)
+	{
+		return;
+	}
+
+	for (i = 1; i < par->chunksNum; i++)
+	{
+		clearData(par->chunksArr[i].ctx);
+	}
+	par->chunksNum = 0;
+}
+
+/* Frees the contexts of the chunks. */
+void freeParallelRead(assemblyContext *ctx)
+{
+	parallelState *par = ctx->parallel;
+	int i;
+
+	if (!par)
+	{
+		return;
+	}
+
+	for (i = 1; i < par->contextsNum; i++)
+	{
+		freeContext(par->chunksArr[i].ctx);
+	}
+	free(par->chunksArr);
+	free(par->rangesArr);
+	free(par);
+	ctx->parallel = NULL;
+}
+
+/* ====== Parallel Second Read ====== */
+
+/* A worker thread. Encodes a range of instructions into its part of the memory image. */
+void *encodeRangeWorker(void *arg)
+{
+	instrRange *range = (instrRange *)arg;
+
+	range->errorsNum = addInstructionsToMemory(&range->ctx, range->memoryArr, range->memorySize, range->lines,
+		range->firstInstr, range->lastInstr);
+	return NULL;
+}
+
+/* Starts the worker thread of a range, with a copy of the context of the file. */
+/* The copy shares the labels and the instructions (they aren't changed by the second read), */
+/* and has its own log, extern uses and lookups count. Returns "FALSE" if the thread didn't start. */
+bool startRange(assemblyContext *ctx, instrRange *range)
+{
+	range->ctx = *ctx;
+	range->ctx.log = tmpfile();
+	range->ctx.messagesNum = 0;
+	range->ctx.onMessage = NULL;
+	range->ctx.stats.lookupsNum = 0;
+	range->ctx.externArr = NULL;
+	range->ctx.externNum = 0;
+	range->ctx.externArrSize = 0;
+	range->hasThread = (range->ctx.log && pthread_create(&range->thread, NULL, encodeRangeWorker, range) == 0) ? TRUE : FALSE;
+	return range->hasThread;
+}
+
+/* Adds the messages, extern uses and lookups count of a range which was encoded by a worker thread to the file. */
+/* Returns the number of errors found in the range. */
+int joinRange(assemblyContext *ctx, instrRange *range)
+{
+	int errorsFound = range->errorsNum;
+
+	printLog(range->ctx.log, ctx->log);
+	range->ctx.log = NULL;
+	ctx->messagesNum += range->ctx.messagesNum;
+	ctx->stats.lookupsNum += range->ctx.stats.lookupsNum;
+
+	/* The ranges are joined in order, so the extern uses stay in the order of their addresses */
+	if (range->ctx.externNum)
+	{
+		if (growArray((void **)&ctx->externArr, &ctx->externArrSize, ctx->externNum + range->ctx.externNum, sizeof(externRef)))
+		{
+			memcpy(ctx->externArr + ctx->externNum, range->ctx.externArr, range->ctx.externNum * sizeof(externRef));
+			ctx->externNum += range->ctx.externNum;
+		}
+		else
+		{
+			printError(ctx, 0, "Not enough memory for more extern labels.");
+			errorsFound++;
+		}
+	}
+	free(range->ctx.externArr);
+	return errorsFound;
+}
+
+/* Reading the data from the first read for the second time with up to ctx->options.threadsNum threads (see secondFileRead). */
+/* If there are too few instructions to cut, it's done by secondFileRead. */
+/* Returns how many errors were found (memoryArr and the messages are the same as secondFileRead's). */
+int parallelSecondRead(assemblyContext *ctx, int *memoryArr, linesList *lines, int IC, int DC)
+{
+	parallelState *par;
+	instrRange *range;
+	int errorsFound, memoryCounter = IC, rangesNum, rangeInstrs, i;
+
+	if (ctx->options.threadsNum < 2 || ctx->instrNum < 2 * MIN_RANGE_INSTRS || !(par = getParallelState(ctx)))
+	{
+		return secondFileRead(ctx, memoryArr, lines, IC, DC);
+	}
+
+	/* Like secondFileRead, the labels and the entries are done before the instructions */
+	updateDataLabelsAddress(ctx, IC);
+	errorsFound = countIllegalEntries(ctx);
+
+	/* The ranges have at least MIN_RANGE_INSTRS instructions */
+	rangeInstrs = (ctx->instrNum + ctx->options.threadsNum - 1) / ctx->options.threadsNum;
+	if (rangeInstrs < MIN_RANGE_INSTRS)
+	{
+		rangeInstrs = MIN_RANGE_INSTRS;
+	}
+	rangesNum = (ctx->instrNum + rangeInstrs - 1) / rangeInstrs;
+
+	/* Start the ranges after the first one, which is encoded here */
+	for (i = 1; i < rangesNum; i++)
+	{
+		range = &par->rangesArr[i];
+		range->memoryArr = memoryArr;
+		range->memorySize = IC + DC;
+		range->lines = lines;
+		range->firstInstr = i * rangeInstrs;
+		range->lastInstr = (i == rangesNum - 1) ? ctx->instrNum : range->firstInstr + rangeInstrs;
+		startRange(ctx, range);
+	}
+	errorsFound += addInstructionsToMemory(ctx, memoryArr, IC + DC, lines, 0, rangeInstrs);
+
+	/* Join the ranges in order (a range without a thread is encoded here) */
+	for (i = 1; i < rangesNum; i++)
+	{
+		range = &par->rangesArr[i];
+		if (range->hasThread)
+		{
+			pthread_join(range->thread, NULL);
+			errorsFound += joinRange(ctx, range);
+		}
+		else
+		{
+			if (range->ctx.log)
+			{
+				fclose(range->ctx.log);
+			}
+			errorsFound += addInstructionsToMemory(ctx, memoryArr, IC + DC, lines, range->firstInstr, range->lastInstr);
+		}
+	}
+
+	/* Add the data from ctx->dataArr to the end of memoryArr (after the IC words of the code) */
+	addDataToMemory(ctx, memoryArr, &memoryCounter, IC + DC, DC);
+
+	return errorsFound;
+}
@@ -1,299 +1,542 @@
-/*
-This file gets the data structures from the first file read, and convert them into bits.
-
-*/
-
-/* ========== Includes ========== */
-#include "assembler.h"
-
-/* ========== Externs ========== */
-/* Use the commands list from firstRead.c */
-extern const command g_cmdArr[];
-
-/* Use the data from firstRead.c */
-extern labelInfo g_labelArr[MAX_LABELS_NUM];
-extern int g_labelNum;
-lineInfo *g_entryLines[MAX_LABELS_NUM];
-extern int g_entryLabelsNum;
-extern int g_dataArr[MAX_DATA_NUM];
-extern macro g_macroArr[MAX_LABELS_NUM];
-extern int macroArrInd;
-/* ========== Methods ========== */
-
-/* Updates the addresses of all the data labels in g_labelArr. */
-void updateDataLabelsAddress(int IC)
-{
-	int i;
-
-	/* Search in the array for label with isData flag */
-	for (i = 0; i < g_labelNum; i++)
-	{
-		if (g_labelArr[i].isData)
-		{
-			/* Increase the address */
-			g_labelArr[i].address += IC;
-		}
-	}
-}
-
-/* Returns the number of illegal entry lines in g_entryLines. */
-int countIllegalEntries()
-{
-	int i, ret = 0;
-	labelInfo *label;
-
-	for (i = 0; i < g_entryLabelsNum; i++)
-	{
-		label = getLabel(g_entryLines[i]->lineStr);
-		if (label)
-		{
-			if (label->isExtern)
-			{
-				printError(g_entryLines[i]->lineNum, "The parameter for .entry can't be an external label.");
-				ret++;
-			}
-		}
-		else
-		{
-			printError(g_entryLines[i]->lineNum, "No such label as \"%s\".", g_entryLines[i]->lineStr);
-			ret++;
-		}
-	}
-
-	return ret;
-}
-
-/* If the op is a label, this method updates the value of it to be the address of the label. */
-/* Returns "FALSE" if there is an error, "TRUE" otherwise. */
-bool updateLableOpAddress(operandInfo *op, int lineNum)
-{
-	if (op->type == LABEL || op->type == INDEX) /*we want to set up the address for the LABEL location*/
-	{
-		labelInfo *label = getLabel(op->str);
-
-		/* Check if op.str is a real label name */
-		if (label == NULL)
-		{
-			/* Print errors (legal name is illegal or not exists yet) */
-			if (isLegalLabel(op->str, lineNum, TRUE))
-			{
-				printError(lineNum, "No such label as \"%s\"", op->str);
-			}
-			return FALSE;
-		}
-
-		op->value = label->address;
-	}
-
-	return TRUE;
-}
-
-/* Returns the int value of a memory word. */
-int getNumFromMemoryWord(memoryWord memory)
-{
-	/* Create an int of "MEMORY_WORD_LENGTH" times '1', and all the rest are '0' */
-	unsigned int mask = ~0;
-	mask >>= (sizeof(int) * BYTE_SIZE - MEMORY_WORD_LENGTH);
-
-	/* The mask makes sure we only use the first "MEMORY_WORD_LENGTH" bits */
-	return mask & ((memory.valueBits.value << 2) + memory.era);
-}
-
-/* Returns the id of the addressing method of the operand */
-int getOpTypeId(operandInfo op)
-{
-	/* Check if the operand have legal type */
-	if (op.type != INVALID)
-	{
-		/* NUMBER = 0, LABEL = 1,INDEX = 2, REGISTER = 3 */
-		return (int)op.type;
-	}
-
-	return 0;
-}
-
-/* Returns a memory word which represents the command in a line. */
-memoryWord getCmdMemoryWord(lineInfo line)
-{
-	memoryWord memory = { 0 };
-
-	/* Update all the bits in the command word */
-	memory.era = (eraType)ABSOLUTE; /* Commands are absolute */
-	memory.valueBits.cmdBits.dest = getOpTypeId(line.op2);
-	memory.valueBits.cmdBits.src = getOpTypeId(line.op1);
-	memory.valueBits.cmdBits.opcode = line.cmd->opcode;
-	memory.valueBits.cmdBits.unUsed = 0;
-	return memory;
-}
-
-/* Returns a memory word which represents the operand (assuming it's a valid operand). */
-memoryWord getOpMemoryWord(operandInfo op, bool isDest)
-{
-	memoryWord memory = { 0 };
-
-	/* Check if it's a register or not */
-	if (op.type == REGISTER)
-	{
-		memory.era = (eraType)ABSOLUTE; /* Registers are absolute */
-
-		/* Check if it's the dest or src */
-		if (isDest)
-		{
-			memory.valueBits.regBits.destBits = op.value;
-		}
-		else
-		{
-			memory.valueBits.regBits.srcBits = op.value;
-		}
-	}
-
-
-	else
-	{
-		labelInfo *label = getLabel(op.str);
-
-		/* Set era */
-		if (op.type == LABEL && label && label->isExtern)
-		{
-			memory.era = EXTENAL;
-		}
-		else
-		{
-			memory.era = (op.type == NUMBER) ? (eraType)ABSOLUTE : (eraType)RELOCATABLE;
-		}
-
-		memory.valueBits.value = op.value;
-	}
-
-	return memory;
-}
-
-/* Adds the value of a memory word to the memoryArr, and increase the memory counter. */
-void addWordToMemory(int *memoryArr, int *memoryCounter, memoryWord memory)
-{
-	/* Check if memoryArr isn't full yet */
-	if (*memoryCounter < MAX_DATA_NUM)
-	{
-		/* Add the memory word and increase memoryCounter */
-		memoryArr[(*memoryCounter)++] = getNumFromMemoryWord(memory);
-	}
-}
-
-/* Adds a whole line into the memoryArr, and increase the memory counter. */
-bool addLineToMemory(int *memoryArr, int *memoryCounter, lineInfo *line)
-{
-	bool foundError = FALSE;
-
-	/* Don't do anything if the line is error or if it's not a command line */
-	if (!line->isError && line->cmd != NULL)
-	{
-		/* Update the label operands value */
-		if (!updateLableOpAddress(&line->op1, line->lineNum) || !updateLableOpAddress(&line->op2, line->lineNum))
-		{
-			line->isError = TRUE;
-			foundError = TRUE;
-		}
-
-		/* Add the command word to the memory */
-		addWordToMemory(memoryArr, memoryCounter, getCmdMemoryWord(*line));
-
-		if (line->op1.type == REGISTER && line->op2.type == REGISTER)
-		{
-			/* Create the memory word */
-			memoryWord memory = { 0 };
-			memory.era = (eraType)ABSOLUTE; /* Registers are absolute */
-			memory.valueBits.regBits.destBits = line->op2.value;
-			memory.valueBits.regBits.srcBits = line->op1.value;
-
-			/* Add the memory to the memoryArr array */
-			addWordToMemory(memoryArr, memoryCounter, memory);
-		}
-		
-		else
-		{
-			/* Check if there is a source operand in this line */
-			if (line->op1.type != INVALID)
-			{
-				/* Add the op1 word to the memory */
-				line->op1.address = FIRST_ADDRESS + *memoryCounter;
-				addWordToMemory(memoryArr, memoryCounter, getOpMemoryWord(line->op1, FALSE));
-				/* ^^ The FALSE param means it's not the 2nd op */
-				if(line->op1.type == INDEX){
-					memoryWord memory1 = {0};
-					memory1.era = (eraType) ABSOLUTE;
-					memory1.valueBits.value = line->op1.indexVal;
-					addWordToMemory(memoryArr, memoryCounter, memory1);
-				}
-			}
-
-			/*Check if there is a destination operand in this line */
-			if (line->op2.type != INVALID)
-			{
-				/* Add the op2 word to the memory */
-				line->op2.address = FIRST_ADDRESS + *memoryCounter;
-				addWordToMemory(memoryArr, memoryCounter, getOpMemoryWord(line->op2, TRUE));
-				/* ^^ The TRUE param means it's the 2nd op */
-				if(line->op2.type == INDEX){
-					memoryWord memory2 = {0};
-					memory2.era = (eraType) ABSOLUTE;
-					memory2.valueBits.value = line->op2.indexVal;
-					addWordToMemory(memoryArr, memoryCounter, memory2);
-				}
-			}
-		}
-	}
-
-	return !foundError;
-}
-
-/* Adds the data from g_dataArr to the end of memoryArr. */
-void addDataToMemory(int *memoryArr, int *memoryCounter, int DC)
-{
-	int i;
-	/* Create an int of "MEMORY_WORD_LENGTH" times '1', and all the rest are '0' */
-	unsigned int mask = ~0;
-	mask >>= (sizeof(int) * BYTE_SIZE - MEMORY_WORD_LENGTH);
-
-	/* Add each int from g_dataArr to the end of memoryArr */
-	for (i = 0; i < DC; i++)
-	{
-		if (*memoryCounter < MAX_DATA_NUM)
-		{
-			/* The mask makes sure we only use the first "MEMORY_WORD_LENGTH" bits */
-			memoryArr[(*memoryCounter)++] = mask & g_dataArr[i];
-		}
-		else
-		{
-			/* No more space in memoryArr */
-			return;
-		}
-	}
-}
-
-/* Reads the data from the first read for the second time. */
-/* Converts all the lines into the memory. */
-int secondFileRead(int *memoryArr, lineInfo *linesArr, int lineNum, int IC, int DC)
-{
-	int errorsFound = 0, memoryCounter = 0, i;
-
-	/* Update the data labels */
-	updateDataLabelsAddress(IC);
-
-	/* Check if there are illegal entries */
-	errorsFound += countIllegalEntries();
-
-	/* Add each line in linesArr to the memoryArr */
-	for (i = 0; i < lineNum; i++)
-	{
-		if (!addLineToMemory(memoryArr, &memoryCounter, &linesArr[i]))
-		{
-			/* An error was found while adding the line to the memory */
-			errorsFound++;
-		}
-	}
-
-	/* Add the data from g_dataArr to the end of memoryArr */
-	addDataToMemory(memoryArr, &memoryCounter, DC);
-
-	return errorsFound;
-}
+/*
+This file gets the data structures from the first file read, and convert them into bits.
+
+*/
+
+/* ========== Includes ========== */
+#include "assembler.h"
+
+/* ========== Externs ========== */
+/* Use the commands list from firstRead.c */
+extern const command g_cmdArr[];
+
+/* ========== Methods ========== */
+
+/* Updates the addresses of all the data labels in ctx->labelArr. */
+void updateDataLabelsAddress(assemblyContext *ctx, int IC)
+{
+	int i;
+
+	/* Search in the array for label with isData flag */
+	for (i = 0; i < ctx->labelNum; i++)
+	{
+		if (ctx->labelArr[i].isData)
+		{
+			/* Increase the address */
+			ctx->labelArr[i].address += IC;
+		}
+	}
+}
+
+/* Resolves the labels of ctx->entryArr (their labelInd), and returns the number of illegal entries. */
+int countIllegalEntries(assemblyContext *ctx)
+{
+	int i, ret = 0;
+	labelInfo *label;
+	entryLabel *entry;
+
+	for (i = 0; i < ctx->entryLabelsNum; i++)
+	{
+		entry = &ctx->entryArr[i];
+		label = getLabel(ctx, entry->name);
+		if (label)
+		{
+			entry->labelInd = label - ctx->labelArr;
+			if (label->isExtern)
+			{
+				printError(ctx, entry->lineNum, "The parameter for .entry can't be an external label.");
+				ret++;
+			}
+		}
+		else
+		{
+			printError(ctx, entry->lineNum, "No such label as \"%s\".", entry->name);
+			ret++;
+		}
+	}
+
+	return ret;
+}
+
+/* Resolves a label operand to its label: keeps the symbol id, the address and if it's extern. */
+void setLabelOp(assemblyContext *ctx, instrOperand *op, labelInfo *label)
+{
+	op->labelInd = label - ctx->labelArr;
+	op->value = label->address;
+	op->isExtern = (op->type == LABEL && label->isExtern) ? TRUE : FALSE;
+}
+
+/* If the op is a label, this method resolves it to the label 'labelName' (see setLabelOp). */
+/* This is the only lookup of the name, the encoding and the output files use the symbol id. */
+/* Returns "FALSE" if there is an error, "TRUE" otherwise. */
+bool updateLableOpAddress(assemblyContext *ctx, instrOperand *op, char *labelName, int lineNum)
+{
+	if (op->type == LABEL || op->type == INDEX) /*we want to set up the address for the LABEL location*/
+	{
+		labelInfo *label = getLabel(ctx, labelName);
+
+		/* Check if labelName is a real label name */
+		if (label == NULL)
+		{
+			/* Print errors (legal name is illegal or not exists yet) */
+			if (isLegalLabel(ctx, labelName, lineNum, TRUE))
+			{
+				printError(ctx, lineNum, "No such label as \"%s\"", labelName);
+			}
+			return FALSE;
+		}
+
+		setLabelOp(ctx, op, label);
+	}
+
+	return TRUE;
+}
+
+/* Returns the int value of a memory word. */
+int getNumFromMemoryWord(memoryWord memory)
+{
+	/* Create an int of "MEMORY_WORD_LENGTH" times '1', and all the rest are '0' */
+	unsigned int mask = ~0;
+	mask >>= (sizeof(int) * BYTE_SIZE - MEMORY_WORD_LENGTH);
+
+	/* The mask makes sure we only use the first "MEMORY_WORD_LENGTH" bits */
+	return mask & ((memory.valueBits.value << 2) + memory.era);
+}
+
+/* Returns the id of the addressing method of the operand */
+int getOpTypeId(const instrOperand *op)
+{
+	/* Check if the operand have legal type */
+	if (op->type != INVALID)
+	{
+		/* NUMBER = 0, LABEL = 1,INDEX = 2, REGISTER = 3 */
+		return (int)op->type;
+	}
+
+	return 0;
+}
+
+/* Returns a memory word which represents the command of an instruction. */
+memoryWord getCmdMemoryWord(const instruction *instr)
+{
+	memoryWord memory = { 0 };
+
+	/* Update all the bits in the command word */
+	memory.era = (eraType)ABSOLUTE; /* Commands are absolute */
+	memory.valueBits.cmdBits.dest = getOpTypeId(&instr->op2);
+	memory.valueBits.cmdBits.src = getOpTypeId(&instr->op1);
+	memory.valueBits.cmdBits.opcode = instr->opcode;
+	memory.valueBits.cmdBits.unUsed = 0;
+	return memory;
+}
+
+/* Returns a memory word which represents the operand (assuming it's a valid operand). */
+memoryWord getOpMemoryWord(const instrOperand *op, bool isDest)
+{
+	memoryWord memory = { 0 };
+
+	/* Check if it's a register or not */
+	if (op->type == REGISTER)
+	{
+		memory.era = (eraType)ABSOLUTE; /* Registers are absolute */
+
+		/* Check if it's the dest or src */
+		if (isDest)
+		{
+			memory.valueBits.regBits.destBits = op->value;
+		}
+		else
+		{
+			memory.valueBits.regBits.srcBits = op->value;
+		}
+	}
+
+
+	else
+	{
+		/* Set era */
+		if (op->isExtern)
+		{
+			memory.era = EXTENAL;
+		}
+		else
+		{
+			memory.era = (op->type == NUMBER) ? (eraType)ABSOLUTE : (eraType)RELOCATABLE;
+		}
+
+		memory.valueBits.value = op->value;
+	}
+
+	return memory;
+}
+
+/* Returns the distance of the word of an operand from the command word of the instruction. */
+int getOpWordOffset(const instruction *instr, bool isDest)
+{
+	/* Two registers share one word */
+	if (!isDest || instr->op1.type == INVALID || (instr->op1.type == REGISTER && instr->op2.type == REGISTER))
+	{
+		return 1;
+	}
+
+	/* The destination is after the source word (and its index word) */
+	return (instr->op1.type == INDEX) ? 3 : 2;
+}
+
+/* Adds the value of a memory word to the memoryArr (of memorySize words), and increase the memory counter. */
+void addWordToMemory(int *memoryArr, int *memoryCounter, int memorySize, memoryWord memory)
+{
+	/* Check if memoryArr isn't full yet */
+	if (*memoryCounter < memorySize)
+	{
+		/* Add the memory word and increase memoryCounter */
+		memoryArr[(*memoryCounter)++] = getNumFromMemoryWord(memory);
+	}
+}
+
+/* Adds the words of an instruction into the memoryArr (of memorySize words), and increase the memory counter. */
+/* The label operands must already have their values. */
+void addCmdWordsToMemory(int *memoryArr, int *memoryCounter, int memorySize, const instruction *instr)
+{
+	/* Add the command word to the memory */
+	addWordToMemory(memoryArr, memoryCounter, memorySize, getCmdMemoryWord(instr));
+
+	if (instr->op1.type == REGISTER && instr->op2.type == REGISTER)
+	{
+		/* Create the memory word */
+		memoryWord memory = { 0 };
+		memory.era = (eraType)ABSOLUTE; /* Registers are absolute */
+		memory.valueBits.regBits.destBits = instr->op2.value;
+		memory.valueBits.regBits.srcBits = instr->op1.value;
+
+		/* Add the memory to the memoryArr array */
+		addWordToMemory(memoryArr, memoryCounter, memorySize, memory);
+	}
+	
+	else
+	{
+		/* Check if there is a source operand in this line */
+		if (instr->op1.type != INVALID)
+		{
+			/* Add the op1 word to the memory */
+			addWordToMemory(memoryArr, memoryCounter, memorySize, getOpMemoryWord(&instr->op1, FALSE));
+			/* ^^ The FALSE param means it's not the 2nd op */
+			if(instr->op1.type == INDEX){
+				memoryWord memory1 = {0};
+				memory1.era = (eraType) ABSOLUTE;
+				memory1.valueBits.value = instr->op1.indexVal;
+				addWordToMemory(memoryArr, memoryCounter, memorySize, memory1);
+			}
+		}
+
+		/*Check if there is a destination operand in this line */
+		if (instr->op2.type != INVALID)
+		{
+			/* Add the op2 word to the memory */
+			addWordToMemory(memoryArr, memoryCounter, memorySize, getOpMemoryWord(&instr->op2, TRUE));
+			/* ^^ The TRUE param means it's the 2nd op */
+			if(instr->op2.type == INDEX){
+				memoryWord memory2 = {0};
+				memory2.era = (eraType) ABSOLUTE;
+				memory2.valueBits.value = instr->op2.indexVal;
+				addWordToMemory(memoryArr, memoryCounter, memorySize, memory2);
+			}
+		}
+	}
+}
+
+/* Copies an operand of a parsed line to an instruction operand. */
+void setInstrOperand(instrOperand *instrOp, const operandInfo *op)
+{
+	instrOp->value = op->value;
+	instrOp->indexVal = op->indexVal;
+	instrOp->labelInd = -1;
+	instrOp->type = (signed char)op->type;
+	instrOp->isExtern = FALSE;
+}
+
+/* Fills the instruction of a command line, which starts at the word 'wordInd'. */
+void setInstruction(instruction *instr, const lineInfo *line, int lineInd, int wordInd)
+{
+	instr->lineInd = lineInd;
+	instr->wordInd = wordInd;
+	instr->opcode = (unsigned char)line->cmd->opcode;
+	setInstrOperand(&instr->op1, &line->op1);
+	setInstrOperand(&instr->op2, &line->op2);
+}
+
+/* Adds the instruction of a parsed line (the line with the index 'lineInd' in the lines list) to ctx->instrArr. */
+/* Lines with errors and lines without a command don't have instructions. Returns "FALSE" if there isn't enough memory. */
+bool addInstruction(assemblyContext *ctx, lineInfo *line, int lineInd)
+{
+	if (line->isError || line->cmd == NULL)
+	{
+		return TRUE;
+	}
+
+	if (!growArray((void **)&ctx->instrArr, &ctx->instrArrSize, ctx->instrNum, sizeof(instruction)))
+	{
+		return FALSE;
+	}
+
+	setInstruction(&ctx->instrArr[ctx->instrNum++], line, lineInd, line->address - FIRST_ADDRESS);
+	return TRUE;
+}
+
+/* Adds a use of an extern label by an operand word of the instruction to ctx->externArr. Returns if it succeeded. */
+bool addInstrExternRef(assemblyContext *ctx, instruction *instr, bool isDest)
+{
+	if (!addExternRef(ctx, isDest ? instr->op2.labelInd : instr->op1.labelInd,
+		FIRST_ADDRESS + instr->wordInd + getOpWordOffset(instr, isDest)))
+	{
+		printError(ctx, 0, "Not enough memory for more extern labels.");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* Adds an instruction into the memoryArr (of memorySize words), and increase the memory counter. */
+/* The names of the labels are taken from its line (in 'lines'). The uses of extern labels are added to ctx->externArr */
+/* (the instructions are added in the order of their addresses, so the list is in order too). */
+/* Returns "FALSE" if a label doesn't exist. */
+bool addLineToMemory(assemblyContext *ctx, int *memoryArr, int *memoryCounter, int memorySize, instruction *instr, linesList *lines)
+{
+	bool foundError = FALSE;
+	lineInfo *line;
+
+	/* Update the label operands value (only they need the line) */
+	if (instr->op1.type == LABEL || instr->op1.type == INDEX || instr->op2.type == LABEL || instr->op2.type == INDEX)
+	{
+		line = getLine(lines, instr->lineInd);
+		if (!updateLableOpAddress(ctx, &instr->op1, line->op1.str, line->lineNum) ||
+			!updateLableOpAddress(ctx, &instr->op2, line->op2.str, line->lineNum))
+		{
+			line->isError = TRUE;
+			foundError = TRUE;
+		}
+
+		/* Keep the uses of extern labels for the .ext file */
+		else if ((instr->op1.isExtern && !addInstrExternRef(ctx, instr, FALSE)) ||
+			(instr->op2.isExtern && !addInstrExternRef(ctx, instr, TRUE)))
+		{
+			foundError = TRUE;
+		}
+	}
+
+	addCmdWordsToMemory(memoryArr, memoryCounter, memorySize, instr);
+
+	return !foundError;
+}
+
+/* Adds the data from ctx->dataArr to the end of memoryArr (of memorySize words). */
+void addDataToMemory(assemblyContext *ctx, int *memoryArr, int *memoryCounter, int memorySize, int DC)
+{
+	int i;
+	/* Create an int of "MEMORY_WORD_LENGTH" times '1', and all the rest are '0' */
+	unsigned int mask = ~0;
+	mask >>= (sizeof(int) * BYTE_SIZE - MEMORY_WORD_LENGTH);
+
+	/* Add each int from ctx->dataArr to the end of memoryArr */
+	for (i = 0; i < DC; i++)
+	{
+		if (*memoryCounter < memorySize)
+		{
+			/* The mask makes sure we only use the first "MEMORY_WORD_LENGTH" bits */
+			memoryArr[(*memoryCounter)++] = mask & ctx->dataArr[i];
+		}
+		else
+		{
+			/* No more space in memoryArr */
+			return;
+		}
+	}
+}
+
+/* Adds the instructions from 'firstInstr' to 'lastInstr' (not included) of ctx->instrArr into memoryArr (of memorySize words). */
+/* Every instruction is added at its own word (its wordInd from the first read), so a few ranges of instructions */
+/* can be added at the same time into their own parts of memoryArr (see parallelSecondRead). Returns the number of errors found. */
+int addInstructionsToMemory(assemblyContext *ctx, int *memoryArr, int memorySize, linesList *lines, int firstInstr, int lastInstr)
+{
+	int errorsFound = 0, memoryCounter, i;
+
+	for (i = firstInstr; i < lastInstr; i++)
+	{
+		memoryCounter = ctx->instrArr[i].wordInd;
+		if (!addLineToMemory(ctx, memoryArr, &memoryCounter, memorySize, &ctx->instrArr[i], lines))
+		{
+			/* An error was found while adding the line to the memory */
+			errorsFound++;
+		}
+	}
+
+	return errorsFound;
+}
+
+/* Reads the data from the first read for the second time. */
+/* Converts all the instructions into the memory (memoryArr has IC + DC words). */
+int secondFileRead(assemblyContext *ctx, int *memoryArr, linesList *lines, int IC, int DC)
+{
+	int errorsFound = 0, memoryCounter = IC;
+
+	/* Update the data labels */
+	updateDataLabelsAddress(ctx, IC);
+
+	/* Check if there are illegal entries */
+	errorsFound += countIllegalEntries(ctx);
+
+	/* Add each instruction to the memoryArr */
+	errorsFound += addInstructionsToMemory(ctx, memoryArr, IC + DC, lines, 0, ctx->instrNum);
+
+	/* Add the data from ctx->dataArr to the end of memoryArr (after the IC words of the code) */
+	addDataToMemory(ctx, memoryArr, &memoryCounter, IC + DC, DC);
+
+	return errorsFound;
+}
+
+/* ====== Single Pass ====== */
+
+/* If the op is a label which is already known, resolves it to the label (see setLabelOp). */
+/* Returns "FALSE" if the op must wait for the end of the file (see finishSinglePass), "TRUE" otherwise. */
+bool updateKnownLabelOp(assemblyContext *ctx, instrOperand *op, char *labelName)
+{
+	labelInfo *label;
+
+	if (op->type != LABEL && op->type != INDEX)
+	{
+		return TRUE;
+	}
+
+	label = getLabel(ctx, labelName);
+	if (!label)
+	{
+		return FALSE;
+	}
+
+	/* Data labels move after the code is done, and extern labels add .ext lines (their fixups keep the label) */
+	setLabelOp(ctx, op, label);
+	return (label->isData || label->isExtern) ? FALSE : TRUE;
+}
+
+/* Adds a fixup for a label operand, which is in the word 'wordInd' of ctx->codeArr. */
+/* labelInd is the label if it's already known, or -1. Returns if it succeeded. */
+bool addFixup(assemblyContext *ctx, char *labelName, int labelInd, opType type, int wordInd, bool isDest, int lineNum)
+{
+	fixup *fix;
+
+	if (!growArray((void **)&ctx->fixupArr, &ctx->fixupArrSize, ctx->fixupNum, sizeof(fixup)))
+	{
+		return FALSE;
+	}
+
+	fix = &ctx->fixupArr[ctx->fixupNum++];
+	fix->labelName = labelName;
+	fix->labelInd = labelInd;
+	fix->wordInd = wordInd;
+	fix->type = type;
+	fix->isDest = isDest;
+	fix->lineNum = lineNum;
+	return TRUE;
+}
+
+/* Encodes a command line into ctx->codeArr while reading the file (single pass mode). */
+/* Labels which aren't known yet are added to ctx->fixupArr. Returns "FALSE" if there isn't enough memory. */
+bool encodeLine(assemblyContext *ctx, lineInfo *line)
+{
+	instruction instr;
+	bool isOp1Known, isOp2Known;
+
+	/* Only command lines without errors have memory words (like in addInstruction) */
+	if (line->isError || line->cmd == NULL)
+	{
+		return TRUE;
+	}
+
+	/* Make a place for all the words of the line */
+	if (!growArray((void **)&ctx->codeArr, &ctx->codeArrSize, ctx->codeNum + MAX_LINE_WORDS - 1, sizeof(int)))
+	{
+		return FALSE;
+	}
+
+	setInstruction(&instr, line, 0, ctx->codeNum);
+	isOp1Known = updateKnownLabelOp(ctx, &instr.op1, line->op1.str);
+	isOp2Known = updateKnownLabelOp(ctx, &instr.op2, line->op2.str);
+	addCmdWordsToMemory(ctx->codeArr, &ctx->codeNum, ctx->codeArrSize, &instr);
+
+	/* Keep the addresses of the operand words (the line cache uses them) */
+	line->op1.address = FIRST_ADDRESS + instr.wordInd + getOpWordOffset(&instr, FALSE);
+	line->op2.address = FIRST_ADDRESS + instr.wordInd + getOpWordOffset(&instr, TRUE);
+
+	/* The unknown operands got a temporary word, which is replaced by finishSinglePass */
+	return (isOp1Known || addFixup(ctx, line->op1.str, instr.op1.labelInd, line->op1.type, line->op1.address - FIRST_ADDRESS, FALSE, line->lineNum)) &&
+		(isOp2Known || addFixup(ctx, line->op2.str, instr.op2.labelInd, line->op2.type, line->op2.address - FIRST_ADDRESS, TRUE, line->lineNum));
+}
+
+/* Adds a use of an extern label to ctx->externArr. Returns if it succeeded. */
+bool addExternRef(assemblyContext *ctx, int labelInd, int address)
+{
+	if (!growArray((void **)&ctx->externArr, &ctx->externArrSize, ctx->externNum, sizeof(externRef)))
+	{
+		return FALSE;
+	}
+
+	ctx->externArr[ctx->externNum].labelInd = labelInd;
+	ctx->externArr[ctx->externNum].address = address;
+	ctx->externNum++;
+	return TRUE;
+}
+
+/* Finishes the single pass mode, when all the labels are known. */
+/* Writes the fixups, and copies the code and the data into memoryArr (of IC + DC words). */
+/* Returns the number of errors found (the same errors secondFileRead finds). */
+int finishSinglePass(assemblyContext *ctx, int *memoryArr, int IC, int DC)
+{
+	int errorsFound = 0, memoryCounter = ctx->codeNum, errorLineNum = 0, i;
+	instrOperand op = { 0 };
+	fixup *fix;
+
+	/* Update the data labels */
+	updateDataLabelsAddress(ctx, IC);
+
+	/* Check if there are illegal entries */
+	errorsFound += countIllegalEntries(ctx);
+
+	/* Write the label operands (the fixups are in the order of the lines) */
+	for (i = 0; i < ctx->fixupNum; i++)
+	{
+		fix = &ctx->fixupArr[i];
+
+		/* Like in addLineToMemory, only the first bad label of a line is an error */
+		if (fix->lineNum == errorLineNum)
+		{
+			continue;
+		}
+
+		/* The labels which were known when the line was encoded aren't looked up again */
+		op.type = (signed char)fix->type;
+		if (fix->labelInd >= 0)
+		{
+			setLabelOp(ctx, &op, &ctx->labelArr[fix->labelInd]);
+		}
+		else if (!updateLableOpAddress(ctx, &op, fix->labelName, fix->lineNum))
+		{
+			errorLineNum = fix->lineNum;
+			errorsFound++;
+			continue;
+		}
+
+		ctx->codeArr[fix->wordInd] = getNumFromMemoryWord(getOpMemoryWord(&op, fix->isDest));
+
+		/* Keep the uses of extern labels for the .ext file */
+		if (op.isExtern && !addExternRef(ctx, op.labelInd, FIRST_ADDRESS + fix->wordInd))
+		{
+			printError(ctx, 0, "Not enough memory for more extern labels.");
+			errorsFound++;
+		}
+	}
+
+	/* Copy the code, and add the data from ctx->dataArr after it */
+	memcpy(memoryArr, ctx->codeArr, ctx->codeNum * sizeof(int));
+	addDataToMemory(ctx, memoryArr, &memoryCounter, IC + DC, DC);
+
+	return errorsFound;
+}
@@ -0,0 +1,678 @@
+/*
+This file runs the assembler as a server on a local (Unix domain) socket, and has the client which sends it files
+(see --serve and --client). The server keeps a few worker threads, each with its own context, so the tables, the
+arrays and the arena of a worker are already warm for the next request, and a few requests are served at the same time.
+
+Every connection has one request, which the client ends by shutting down its side of the socket:
+	assemble <name>				The file name without the ".as" ending (like in the command line)
+	dir <path>					Optional - the directory of a relative name (the current directory of the client)
+	out-dir <path>				Optional - the directory of the output files (next to the source file without it)
+	options <maxWords> <singlePass> <useCache> <format> <stats> <stream> <threadsNum>
+								Optional - the options of the file (the options of the server without it)
+	source <length>				Optional - the source is the next <length> bytes, instead of the file <name>.as
+	end							Ends a request without a source
+The answer has the messages of the file (the same messages the command line prints), and its statistics:
+	messages <length>
+	<the messages>
+	stats <files> <failed> <lines> <words> <lookups> <allocs> <blocks> <bytes> <the seconds of every phase>
+*/
+
+/* ======== Includes ======== */
+#include "assembler.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* ====== Data Structures ====== */
+
+/* The connections which wait for a worker of the server */
+typedef struct
+{
+	int fdsArr[SERVE_QUEUE_SIZE];
+	int first;						/* The index of the oldest connection */
+	int count;
+	bool isClosed;					/* TRUE when the server stops */
+	pthread_mutex_t lock;			/* Protects all the fields */
+	pthread_cond_t notEmpty;		/* Signaled when a connection is pushed, or when the queue is closed */
+	pthread_cond_t notFull;			/* Signaled when a connection is popped */
+	assemblyOptions options;		/* The options of the requests without options */
+} connectionsQueue;
+
+/* An assemble request (the strings are in the request, see parseRequest) */
+typedef struct
+{
+	char *name;
+	char *workDir;
+	char *outDir;
+	char *source;					/* NULL if the source is in the file */
+	size_t sourceSize;
+	assemblyOptions options;
+} assembleRequest;
+
+/* ====== Globals ====== */
+volatile sig_atomic_t g_stopServer;	/* Set by SIGINT and SIGTERM (see stopServer) */
+
+/* ====== Methods ====== */
+
+/* Sets the address of a Unix domain socket. Returns "FALSE" if the path is too long. */
+bool setSocketAddress(struct sockaddr_un *address, char *socketPath)
+{
+	memset(address, 0, sizeof(struct sockaddr_un));
+	address->sun_family = AF_UNIX;
+	if (strlen(socketPath) >= sizeof(address->sun_path))
+	{
+		return FALSE;
+	}
+	strcpy(address->sun_path, socketPath);
+	return TRUE;
+}
+
+/* Returns a socket which is connected to the server on socketPath (or -1 if there is no server). */
+int connectToServer(char *socketPath)
+{
+	struct sockaddr_un address;
+	int fd;
+
+	if (!setSocketAddress(&address, socketPath) || (fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+	{
+		return -1;
+	}
+	if (connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* Writes all the 'size' bytes of data to fd. Returns "FALSE" if it failed. */
+bool writeAll(int fd, const char *data, size_t size)
+{
+	ssize_t count;
+
+	while (size > 0)
+	{
+		count = write(fd, data, size);
+		if (count < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (count <= 0)
+		{
+			return FALSE;
+		}
+		data += count;
+		size -= count;
+	}
+	return TRUE;
+}
+
+/* Reads everything the other side of the socket sends, until it shuts down its side, into the arena. */
+/* Returns the text (with a '\0' after it), or NULL if it failed. */
+char *readConnection(memoryArena *arena, int fd, size_t *size)
+{
+	int fdCopy = dup(fd);
+	FILE *in = (fdCopy >= 0) ? fdopen(fdCopy, "r") : NULL;
+	char *text;
+
+	if (!in)
+	{
+		if (fdCopy >= 0)
+		{
+			close(fdCopy);
+		}
+		return NULL;
+	}
+
+	text = readSourceFile(arena, in, size);
+	fclose(in);
+	return text;
+}
+
+/* Ignores SIGPIPE, so writing to a socket which was closed by the other side is an error, and not the end of the process. */
+void ignoreBrokenPipes()
+{
+	struct sigaction action;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = SIG_IGN;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGPIPE, &action, NULL);
+}
+
+/* ====== Connections Queue ====== */
+
+/* Pushes a connection to the queue. Waits while the queue is full. */
+void pushConnection(connectionsQueue *queue, int fd)
+{
+	pthread_mutex_lock(&queue->lock);
+	while (queue->count == SERVE_QUEUE_SIZE)
+	{
+		pthread_cond_wait(&queue->notFull, &queue->lock);
+	}
+	queue->fdsArr[(queue->first + queue->count++) % SERVE_QUEUE_SIZE] = fd;
+	pthread_cond_signal(&queue->notEmpty);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+/* Pops the oldest connection from the queue. Waits while it's empty. */
+/* Returns -1 if the queue is closed and empty. */
+int popConnection(connectionsQueue *queue)
+{
+	int fd = -1;
+
+	pthread_mutex_lock(&queue->lock);
+	while (queue->count == 0 && !queue->isClosed)
+	{
+		pthread_cond_wait(&queue->notEmpty, &queue->lock);
+	}
+	if (queue->count)
+	{
+		fd = queue->fdsArr[queue->first];
+		queue->first = (queue->first + 1) % SERVE_QUEUE_SIZE;
+		queue->count--;
+		pthread_cond_signal(&queue->notFull);
+	}
+	pthread_mutex_unlock(&queue->lock);
+	return fd;
+}
+
+/* Closes the queue. The workers serve the connections which are already in it, and stop. */
+void closeConnectionsQueue(connectionsQueue *queue)
+{
+	pthread_mutex_lock(&queue->lock);
+	queue->isClosed = TRUE;
+	pthread_cond_broadcast(&queue->notEmpty);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+/* ====== Server ====== */
+
+/* Reads the options of a request into 'options'. Returns "FALSE" if they aren't legal. */
+bool parseRequestOptions(char *str, assemblyOptions *options)
+{
+	int singlePass, useCache, format, stats, stream;
+
+	if (sscanf(str, "%d %d %d %d %d %d %d", &options->maxWords, &singlePass, &useCache, &format, &stats, &stream,
+		&options->threadsNum) != 7 || options->maxWords < 0 || format < FORMAT_TEXT || format > FORMAT_BOTH ||
+		options->threadsNum < 1)
+	{
+		return FALSE;
+	}
+
+	/* The same rules as the command line (the cache and the stream mode are single pass) */
+	options->singlePass = (singlePass || useCache || stream) ? TRUE : FALSE;
+	options->useCache = (useCache && !stream) ? TRUE : FALSE;
+	options->format = (outputFormat)format;
+	options->stats = stats ? TRUE : FALSE;
+	options->stream = stream ? TRUE : FALSE;
+	return TRUE;
+}
+
+/* Parses a request of 'size' chars (see the top of the file). The strings are cut in the request itself. */
+/* Returns "FALSE" if it isn't legal. */
+bool parseRequest(char *str, size_t size, assemblyOptions *defaults, assembleRequest *request)
+{
+	char *end = str + size, *lineEnd, *value;
+
+	memset(request, 0, sizeof(assembleRequest));
+	request->options = *defaults;
+
+	FOREVER
+	{
+		lineEnd = (char *)memchr(str, '\n', end - str);
+		if (!lineEnd)
+		{
+			return FALSE;
+		}
+		*lineEnd = '\0';
+		value = strchr(str, ' ');
+		if (value)
+		{
+			*value++ = '\0';
+		}
+
+		if (strcmp(str, "end") == 0)
+		{
+			break;
+		}
+		else if (value && strcmp(str, "assemble") == 0)
+		{
+			request->name = value;
+		}
+		else if (value && strcmp(str, "dir") == 0)
+		{
+			request->workDir = value;
+		}
+		else if (value && strcmp(str, "out-dir") == 0)
+		{
+			request->outDir = value;
+		}
+		else if (value && strcmp(str, "options") == 0)
+		{
+			if (!parseRequestOptions(value, &request->options))
+			{
+				return FALSE;
+			}
+		}
+		else if (value && strcmp(str, "source") == 0)
+		{
+			/* The source is the rest of the request */
+			request->source = lineEnd + 1;
+			request->sourceSize = strtoul(value, NULL, 10);
+			if (request->sourceSize != (size_t)(end - request->source))
+			{
+				return FALSE;
+			}
+			break;
+		}
+		else
+		{
+			return FALSE;
+		}
+		str = lineEnd + 1;
+	}
+
+	return request->name && *request->name ? TRUE : FALSE;
+}
+
+/* Assembles the file of a request with the context of a worker. */
+void assembleRequestFile(assemblyContext *ctx, assembleRequest *request)
+{
+	FILE *file;
+
+	ctx->options = request->options;
+	ctx->workDir = request->workDir;
+	ctx->outDir = request->outDir;
+
+	if (!request->source)
+	{
+		parseFile(ctx, request->name);
+	}
+	else if ((file = fmemopen(request->source, request->sourceSize, "r")) != NULL)
+	{
+		/* The client opened the file */
+		assembleFile(ctx, request->name, file);
+	}
+	else
+	{
+		printError(ctx, 0, "Not enough memory to assemble the file \"%s.as\".", request->name);
+		clearData(ctx);
+	}
+
+	ctx->workDir = NULL;
+	ctx->outDir = NULL;
+}
+
+/* Writes the answer of a request: the messages and the statistics. Returns "FALSE" if it failed. */
+bool writeAnswer(int fd, char *messages, size_t messagesSize, assemblyStats *stats)
+{
+	char line[BUFSIZ];
+	int length, i;
+
+	length = sprintf(line, "messages %lu\n", (unsigned long)messagesSize);
+	if (!writeAll(fd, line, length) || !writeAll(fd, messages, messagesSize))
+	{
+		return FALSE;
+	}
+
+	length = sprintf(line, "stats %ld %ld %ld %ld %ld %ld %ld %ld", stats->filesNum, stats->failedNum, stats->linesNum,
+		stats->wordsNum, stats->lookupsNum, stats->allocsNum, stats->blocksNum, stats->bytesWritten);
+	for (i = 0; i < STATS_PHASES_NUM; i++)
+	{
+		length += sprintf(line + length, " %.9f", stats->seconds[i]);
+	}
+	line[length++] = '\n';
+	return writeAll(fd, line, length);
+}
+
+/* Serves the request of a connection with the context of a worker. */
+/* The messages are kept in memory, and are sent with the answer. */
+void serveConnection(assemblyContext *ctx, connectionsQueue *queue, int fd)
+{
+	assembleRequest request;
+	char *text, *messages = NULL;
+	size_t size, messagesSize = 0;
+
+	ctx->log = open_memstream(&messages, &messagesSize);
+	if (!ctx->log)
+	{
+		ctx->log = stdout;
+		return;
+	}
+	memset(&ctx->totalStats, 0, sizeof(assemblyStats));
+
+	text = readConnection(&ctx->arena, fd, &size);
+	if (text && parseRequest(text, size, &queue->options, &request))
+	{
+		assembleRequestFile(ctx, &request);
+	}
+	else
+	{
+		printError(ctx, 0, "The request isn't legal.");
+		arenaReset(&ctx->arena);
+	}
+
+	fclose(ctx->log);
+	ctx->log = stdout;
+	writeAnswer(fd, messages, messagesSize, &ctx->totalStats);
+	free(messages);
+}
+
+/* A worker thread of the server. Serves connections from the queue until it's closed. */
+void *serveWorker(void *arg)
+{
+	connectionsQueue *queue = (connectionsQueue *)arg;
+	assemblyContext *ctx = createContext();
+	int fd;
+
+	while ((fd = popConnection(queue)) >= 0)
+	{
+		if (ctx)
+		{
+			serveConnection(ctx, queue, fd);
+		}
+		close(fd);
+	}
+
+	if (ctx)
+	{
+		freeContext(ctx);
+	}
+	return NULL;
+}
+
+/* Handles SIGINT and SIGTERM: the server stops accepting connections. */
+void stopServer(int signalNum)
+{
+	g_stopServer = 1;
+	(void)signalNum;
+}
+
+/* Returns a socket which listens on socketPath (or -1 if it failed, after printing why). */
+/* A socket file which is left from a server that stopped is replaced. */
+int listenOnSocket(char *socketPath)
+{
+	struct sockaddr_un address;
+	int fd = connectToServer(socketPath);
+
+	if (fd >= 0)
+	{
+		close(fd);
+		printf("[Error] A server already listens on \"%s\".\n", socketPath);
+		return -1;
+	}
+	if (!setSocketAddress(&address, socketPath))
+	{
+		printf("[Error] The socket path \"%s\" is too long.\n", socketPath);
+		return -1;
+	}
+
+	unlink(socketPath);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(fd, SERVE_QUEUE_SIZE) < 0)
+	{
+		printf("[Error] Can't listen on \"%s\".\n", socketPath);
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+		return -1;
+	}
+	return fd;
+}
+
+/* Runs the server on socketPath with 'jobsNum' workers, until it gets SIGINT or SIGTERM (see --serve). */
+/* The requests without options get 'options'. Returns the exit code of the process. */
+int serveAssembler(char *socketPath, int jobsNum, assemblyOptions options)
+{
+	connectionsQueue queue;
+	pthread_t *threadsArr = (pthread_t *)malloc(jobsNum * sizeof(pthread_t));
+	struct sigaction action;
+	sigset_t stopSignals;
+	int listenFd, fd, i, threadsNum = 0;
+
+	listenFd = threadsArr ? listenOnSocket(socketPath) : -1;
+	if (listenFd < 0)
+	{
+		free(threadsArr);
+		return 1;
+	}
+
+	/* accept is interrupted by the signals (no SA_RESTART) */
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stopServer;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	ignoreBrokenPipes();
+
+	memset(&queue, 0, sizeof(queue));
+	queue.options = options;
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_cond_init(&queue.notEmpty, NULL);
+	pthread_cond_init(&queue.notFull, NULL);
+
+	/* The workers (and their threads) block the signals, so they only interrupt the accept of this thread */
+	sigemptyset(&stopSignals);
+	sigaddset(&stopSignals, SIGINT);
+	sigaddset(&stopSignals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &stopSignals, NULL);
+	for (i = 0; i < jobsNum; i++)
+	{
+		if (pthread_create(&threadsArr[threadsNum], NULL, serveWorker, &queue) == 0)
+		{
+			threadsNum++;
+		}
+	}
+	pthread_sigmask(SIG_UNBLOCK, &stopSignals, NULL);
+
+	if (threadsNum)
+	{
+		printf("[Info] Serving on \"%s\" with %d worker%s.\n", socketPath, threadsNum, (threadsNum > 1) ? "s" : "");
+		fflush(stdout);
+	}
+	else
+	{
+		printf("[Error] Can't start the workers of the server.\n");
+		g_stopServer = 1;
+	}
+
+	while (!g_stopServer)
+	{
+		fd = accept(listenFd, NULL, NULL);
+		if (fd >= 0)
+		{
+			pushConnection(&queue, fd);
+		}
+		else if (errno != EINTR && errno != ECONNABORTED)
+		{
+			printf("[Error] Can't accept connections on \"%s\".\n", socketPath);
+			break;
+		}
+	}
+
+	/* Serve the connections which were already accepted, and stop */
+	closeConnectionsQueue(&queue);
+	for (i = 0; i < threadsNum; i++)
+	{
+		pthread_join(threadsArr[i], NULL);
+	}
+	close(listenFd);
+	unlink(socketPath);
+	if (threadsNum)
+	{
+		printf("[Info] The server on \"%s\" stopped.\n", socketPath);
+	}
+
+	pthread_mutex_destroy(&queue.lock);
+	pthread_cond_destroy(&queue.notEmpty);
+	pthread_cond_destroy(&queue.notFull);
+	free(threadsArr);
+	return threadsNum ? 0 : 1;
+}
+
+/* ====== Client ====== */
+
+/* Returns the current directory (in the arena), or NULL if it failed. */
+char *getCurrentDir(memoryArena *arena)
+{
+	size_t size = BUFSIZ;
+	char *dir = NULL;
+
+	FOREVER
+	{
+		dir = (char *)arenaGrow(arena, dir, dir ? size / 2 : 0, size);
+		if (!dir)
+		{
+			return NULL;
+		}
+		if (getcwd(dir, size))
+		{
+			return dir;
+		}
+		if (errno != ERANGE)
+		{
+			return NULL;
+		}
+		size *= 2;
+	}
+}
+
+/* Appends the request of a file to 'output' (the output files are in ctx->outDir if it's set). */
+/* With sendSource the source of the file is in the request. */
+/* Returns "FALSE" if the file can't be read (after printing the same message as the command line). */
+bool appendRequest(assemblyContext *ctx, outputBuffer *output, char *name, assemblyOptions *options, bool sendSource)
+{
+	char line[BUFSIZ], *dir = getCurrentDir(&ctx->arena), *source;
+	size_t sourceSize;
+	FILE *file;
+
+	appendOutputStr(&ctx->arena, output, "assemble ");
+	appendOutputStr(&ctx->arena, output, name);
+	if (dir)
+	{
+		appendOutputStr(&ctx->arena, output, "\ndir ");
+		appendOutputStr(&ctx->arena, output, dir);
+	}
+	if (ctx->outDir)
+	{
+		appendOutputStr(&ctx->arena, output, "\nout-dir ");
+		appendOutputStr(&ctx->arena, output, ctx->outDir);
+	}
+	sprintf(line, "\noptions %d %d %d %d %d %d %d\n", options->maxWords, (int)options->singlePass, (int)options->useCache,
+		(int)options->format, (int)options->stats, (int)options->stream, options->threadsNum);
+	appendOutputStr(&ctx->arena, output, line);
+
+	if (!sendSource)
+	{
+		appendOutputStr(&ctx->arena, output, "end\n");
+		return TRUE;
+	}
+
+	/* The server may not see the files of the client */
+	file = openFile(ctx, name, ".as", "r");
+	if (!file)
+	{
+		printf("[Info] Can't open the file \"%s.as\".\n", name);
+		return FALSE;
+	}
+	source = readSourceFile(&ctx->arena, file, &sourceSize);
+	fclose(file);
+	if (!source)
+	{
+		printf("[Error] Not enough memory to read the file \"%s.as\".\n", name);
+		return FALSE;
+	}
+	printf("[Info] Successfully opened the file \"%s.as\".\n", name);
+	sprintf(line, "source %lu\n", (unsigned long)sourceSize);
+	appendOutputStr(&ctx->arena, output, line);
+	appendOutput(&ctx->arena, output, source, sourceSize);
+	return TRUE;
+}
+
+/* Reads the answer of a request: prints the messages, and adds the statistics to 'totalStats'. */
+/* Returns "FALSE" if the answer isn't legal. */
+bool readAnswer(char *answer, size_t size, assemblyStats *totalStats)
+{
+	assemblyStats stats;
+	unsigned long messagesSize;
+	char *str, *end = answer + size;
+	int length, i;
+
+	if (sscanf(answer, "messages %lu", &messagesSize) != 1 || !(str = strchr(answer, '\n')) ||
+		messagesSize > (unsigned long)(end - str - 1))
+	{
+		return FALSE;
+	}
+	fwrite(str + 1, 1, messagesSize, stdout);
+	str += 1 + messagesSize;
+
+	memset(&stats, 0, sizeof(stats));
+	if (sscanf(str, "stats %ld %ld %ld %ld %ld %ld %ld %ld%n", &stats.filesNum, &stats.failedNum, &stats.linesNum,
+		&stats.wordsNum, &stats.lookupsNum, &stats.allocsNum, &stats.blocksNum, &stats.bytesWritten, &length) != 8)
+	{
+		return FALSE;
+	}
+	for (i = 0, str += length; i < STATS_PHASES_NUM; i++)
+	{
+		stats.seconds[i] = strtod(str, &str);
+	}
+	addStats(totalStats, &stats);
+	return TRUE;
+}
+
+/* Assembles the files on the server on socketPath, and prints their messages like the command line (see --client). */
+/* The output files are in outDir (NULL - next to the source files), and the statistics of all the files are added to */
+/* 'totalStats'. With sendSource the sources are sent in the requests, so the server doesn't read them. */
+/* Returns the exit code of the process. */
+int runClient(char *socketPath, char **fileNames, int filesNum, assemblyOptions options, char *outDir, bool sendSource,
+	assemblyStats *totalStats)
+{
+	assemblyContext *ctx = createContext();
+	outputBuffer request;
+	char *answer;
+	size_t answerSize;
+	int fd, i, exitCode = 0;
+
+	if (!ctx)
+	{
+		printf("[Error] Not enough memory - malloc falied.\n");
+		return 1;
+	}
+	ctx->outDir = outDir;
+	ignoreBrokenPipes();
+
+	for (i = 0; i < filesNum && !exitCode; i++)
+	{
+		memset(&request, 0, sizeof(request));
+		if (appendRequest(ctx, &request, fileNames[i], &options, sendSource))
+		{
+			fd = connectToServer(socketPath);
+			if (fd < 0)
+			{
+				printf("[Error] Can't connect to the server on \"%s\".\n", socketPath);
+				exitCode = 1;
+			}
+			else
+			{
+				if (request.failed || !writeAll(fd, request.data, request.size) || shutdown(fd, SHUT_WR) < 0 ||
+					!(answer = readConnection(&ctx->arena, fd, &answerSize)) || !readAnswer(answer, answerSize, totalStats))
+				{
+					printf("[Error] The server on \"%s\" didn't assemble the file \"%s.as\".\n", socketPath, fileNames[i]);
+					exitCode = 1;
+				}
+				close(fd);
+			}
+		}
+		printf("\n");
+		arenaReset(&ctx->arena);
+	}
+
+	freeContext(ctx);
+	return exitCode;
+}
@@ -0,0 +1,531 @@
+/*
+This file assembles a file as a pipeline of three stages (see --stream):
+a reader thread cuts the file into chunks of whole lines, the parser (the thread of the assembly) parses them
+with firstFileRead, and an encoder thread encodes the instructions and formats their lines of the object file.
+The stages are connected by bounded rings, each with one producer and one consumer, so the reader and the
+encoder never get far ahead of the parser. Every label operand is encoded as a fixup (see finishSinglePass),
+and its word is patched in the formatted lines when the file is done (see writeStreamObjectFile).
+*/
+
+/* ======== Includes ======== */
+#include "assembler.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+/* ====== Data Structures ====== */
+
+/* A bounded ring of pointers, between one producer thread and one consumer thread */
+typedef struct
+{
+	void *itemsArr[STREAM_RING_SIZE];
+	int first;						/* The index of the oldest item */
+	int count;
+	bool isClosed;					/* TRUE when the producer is done */
+	pthread_mutex_t lock;			/* Protects all the fields */
+	pthread_cond_t notEmpty;		/* Signaled when an item is pushed, or when the ring is closed */
+	pthread_cond_t notFull;			/* Signaled when an item is popped */
+} streamRing;
+
+/* A chunk of whole lines of the file. The text is after the header, and has a place for a '\0' after it. */
+typedef struct streamChunk
+{
+	struct streamChunk *next;		/* The chunks the parser got (the lines point into them until the file is done) */
+	size_t size;					/* The number of chars of the text */
+	size_t capacity;
+} streamChunk;
+
+/* An instruction of the parser, with what the encoder needs to add its fixups */
+typedef struct
+{
+	instruction instr;
+	char *op1Name;					/* The label of the source operand (if it's a label) */
+	char *op2Name;					/* The label of the destination operand (if it's a label) */
+	int lineNum;
+} streamInstr;
+
+/* A batch of instructions (the batches are passed to the encoder and back, see streamLine) */
+typedef struct
+{
+	streamInstr instrArr[STREAM_BATCH_SIZE];
+	int instrNum;
+} instrBatch;
+
+/* The state of streaming a file */
+struct streamState
+{
+	assemblyContext *ctx;
+	FILE *file;
+	/* Reader */
+	streamChunk *nextChunk;			/* The chunk the reader fills (it starts with the end of the last chunk) */
+	bool readFailed;				/* TRUE if there wasn't enough memory for a chunk */
+	streamRing chunks;				/* Reader -> parser */
+	bool hasReader;					/* FALSE if the reader thread couldn't start (the parser reads the chunks) */
+	pthread_t reader;
+	/* Parser */
+	streamChunk *firstChunk;		/* The chunks the parser got */
+	streamChunk *lastChunk;
+	instrBatch *batchesArr;			/* STREAM_RING_SIZE batches, allocated by malloc */
+	instrBatch *batch;				/* The batch the parser fills (NULL if it needs a free one) */
+	streamRing batches;				/* Parser -> encoder */
+	streamRing freeBatches;			/* Encoder -> parser (the encoded batches are reused) */
+	/* Encoder (it only uses the code and the fixups of the context, which the parser doesn't use in stream mode) */
+	bool hasEncoder;				/* FALSE if the encoder thread couldn't start (the parser encodes the batches) */
+	pthread_t encoder;
+	bool encodeFailed;				/* TRUE if there wasn't enough memory for the code or the fixups */
+	memoryArena arena;				/* The memory of the object file lines */
+	outputBuffer lines;				/* The lines of the code words in the object file (see appendObjectLines) */
+};
+
+/* ====== Rings ====== */
+
+/* Initializes an empty ring. */
+void initStreamRing(streamRing *ring)
+{
+	ring->first = 0;
+	ring->count = 0;
+	ring->isClosed = FALSE;
+	pthread_mutex_init(&ring->lock, NULL);
+	pthread_cond_init(&ring->notEmpty, NULL);
+	pthread_cond_init(&ring->notFull, NULL);
+}
+
+/* Destroys the lock of a ring. */
+void destroyStreamRing(streamRing *ring)
+{
+	pthread_mutex_destroy(&ring->lock);
+	pthread_cond_destroy(&ring->notEmpty);
+	pthread_cond_destroy(&ring->notFull);
+}
+
+/* Adds an item to the end of the ring. Waits while the ring is full. */
+void pushStreamRing(streamRing *ring, void *item)
+{
+	pthread_mutex_lock(&ring->lock);
+	while (ring->count == STREAM_RING_SIZE)
+	{
+		pthread_cond_wait(&ring->notFull, &ring->lock);
+	}
+	ring->itemsArr[(ring->first + ring->count++) % STREAM_RING_SIZE] = item;
+	pthread_cond_signal(&ring->notEmpty);
+	pthread_mutex_unlock(&ring->lock);
+}
+
+/* Takes the first item of the ring. Waits while the ring is empty. */
+/* Returns NULL if the ring is empty and closed. */
+void *popStreamRing(streamRing *ring)
+{
+	void *item = NULL;
+
+	pthread_mutex_lock(&ring->lock);
+	while (ring->count == 0 && !ring->isClosed)
+	{
+		pthread_cond_wait(&ring->notEmpty, &ring->lock);
+	}
+	if (ring->count)
+	{
+		item = ring->itemsArr[ring->first];
+		ring->first = (ring->first + 1) % STREAM_RING_SIZE;
+		ring->count--;
+		pthread_cond_signal(&ring->notFull);
+	}
+	pthread_mutex_unlock(&ring->lock);
+	return item;
+}
+
+/* Closes the ring. The items which are already in it can still be popped. */
+void closeStreamRing(streamRing *ring)
+{
+	pthread_mutex_lock(&ring->lock);
+	ring->isClosed = TRUE;
+	pthread_cond_signal(&ring->notEmpty);
+	pthread_mutex_unlock(&ring->lock);
+}
+
+/* ====== Reader ====== */
+
+/* Returns a new chunk for 'capacity' chars, which starts with 'size' chars of 'text' (or NULL if there is no memory). */
+streamChunk *newStreamChunk(char *text, size_t size, size_t capacity)
+{
+	streamChunk *chunk = (streamChunk *)malloc(sizeof(streamChunk) + capacity + 1);
+
+	if (chunk)
+	{
+		chunk->next = NULL;
+		chunk->size = size;
+		chunk->capacity = capacity;
+		if (size)
+		{
+			memcpy(chunk + 1, text, size);
+		}
+	}
+	return chunk;
+}
+
+/* Reads the next chunk of whole lines from the file. Only the last line of the file may end without '\n'. */
+/* Returns NULL at the end of the file, or if there isn't enough memory (see readFailed). */
+streamChunk *readStreamChunk(streamState *stream)
+{
+	streamChunk *chunk = stream->nextChunk, *bigger;
+	char *text, *endOfLines;
+	size_t count;
+
+	/* The end of the file was already read */
+	if (!chunk)
+	{
+		return NULL;
+	}
+
+	FOREVER
+	{
+		text = (char *)(chunk + 1);
+		count = fread(text + chunk->size, 1, chunk->capacity - chunk->size, stream->file);
+		chunk->size += count;
+
+		/* The end of the file - the rest is the last chunk */
+		if (!count)
+		{
+			stream->nextChunk = NULL;
+			if (chunk->size)
+			{
+				return chunk;
+			}
+			free(chunk);
+			return NULL;
+		}
+
+		/* Find the end of the last whole line */
+		for (endOfLines = text + chunk->size; endOfLines > text && endOfLines[-1] != '\n'; endOfLines--);
+
+		if (endOfLines > text)
+		{
+			/* The next chunk starts with the rest of the text */
+			stream->nextChunk = newStreamChunk(endOfLines, text + chunk->size - endOfLines, chunk->capacity);
+			if (!stream->nextChunk)
+			{
+				break;
+			}
+			chunk->size = endOfLines - text;
+			return chunk;
+		}
+
+		/* Not even one whole line - make the chunk bigger */
+		if (chunk->size == chunk->capacity)
+		{
+			bigger = (streamChunk *)realloc(chunk, sizeof(streamChunk) + 2 * chunk->capacity + 1);
+			if (!bigger)
+			{
+				break;
+			}
+			chunk = stream->nextChunk = bigger;
+			chunk->capacity *= 2;
+		}
+	}
+
+	stream->readFailed = TRUE;
+	free(chunk);
+	stream->nextChunk = NULL;
+	return NULL;
+}
+
+/* The reader thread. Passes the chunks of the file to the parser. */
+void *readChunksWorker(void *arg)
+{
+	streamState *stream = (streamState *)arg;
+	streamChunk *chunk;
+
+	while ((chunk = readStreamChunk(stream)) != NULL)
+	{
+		pushStreamRing(&stream->chunks, chunk);
+	}
+	closeStreamRing(&stream->chunks);
+	return NULL;
+}
+
+/* ====== Encoder ====== */
+
+/* Encodes an instruction into ctx->codeArr, with a fixup for each label operand. Returns "FALSE" if there isn't enough memory. */
+bool encodeStreamInstr(assemblyContext *ctx, streamInstr *item)
+{
+	instruction *instr = &item->instr;
+
+	if (!growArray((void **)&ctx->codeArr, &ctx->codeArrSize, ctx->codeNum + MAX_LINE_WORDS - 1, sizeof(int)))
+	{
+		return FALSE;
+	}
+
+	/* The label operands get a temporary word, which is replaced by finishSinglePass */
+	instr->wordInd = ctx->codeNum;
+	addCmdWordsToMemory(ctx->codeArr, &ctx->codeNum, ctx->codeArrSize, instr);
+
+	return ((instr->op1.type != LABEL && instr->op1.type != INDEX) ||
+		addFixup(ctx, item->op1Name, -1, (opType)instr->op1.type, instr->wordInd + getOpWordOffset(instr, FALSE), FALSE, item->lineNum)) &&
+		((instr->op2.type != LABEL && instr->op2.type != INDEX) ||
+		addFixup(ctx, item->op2Name, -1, (opType)instr->op2.type, instr->wordInd + getOpWordOffset(instr, TRUE), TRUE, item->lineNum));
+}
+
+/* Encodes a batch of instructions, and formats the lines of their words in the object file. */
+void encodeStreamBatch(streamState *stream, instrBatch *batch)
+{
+	assemblyContext *ctx = stream->ctx;
+	int i, firstWord = ctx->codeNum;
+
+	for (i = 0; i < batch->instrNum && !stream->encodeFailed; i++)
+	{
+		if (!encodeStreamInstr(ctx, &batch->instrArr[i]))
+		{
+			stream->encodeFailed = TRUE;
+		}
+	}
+
+	if (ctx->options.format & FORMAT_TEXT)
+	{
+		appendObjectLines(&stream->arena, &stream->lines, ctx->codeArr, firstWord, ctx->codeNum);
+	}
+	batch->instrNum = 0;
+}
+
+/* The encoder thread. Encodes the batches of the parser, and gives them back. */
+void *encodeBatchesWorker(void *arg)
+{
+	streamState *stream = (streamState *)arg;
+	instrBatch *batch;
+
+	while ((batch = (instrBatch *)popStreamRing(&stream->batches)) != NULL)
+	{
+		encodeStreamBatch(stream, batch);
+		pushStreamRing(&stream->freeBatches, batch);
+	}
+	return NULL;
+}
+
+/* ====== Parser ====== */
+
+/* Passes the batch of the parser to the encoder. */
+void flushStreamBatch(streamState *stream)
+{
+	if (!stream->batch || !stream->batch->instrNum)
+	{
+		return;
+	}
+
+	if (stream->hasEncoder)
+	{
+		pushStreamRing(&stream->batches, stream->batch);
+		stream->batch = NULL;
+	}
+	else
+	{
+		encodeStreamBatch(stream, stream->batch);
+	}
+}
+
+/* Adds the instruction of a parsed line to the batch of the encoder (stream mode, see firstFileRead). */
+/* Lines with errors and lines without a command don't have instructions. Always returns "TRUE". */
+bool streamLine(assemblyContext *ctx, lineInfo *line)
+{
+	streamState *stream = ctx->stream;
+	streamInstr *item;
+
+	if (line->isError || line->cmd == NULL)
+	{
+		return TRUE;
+	}
+
+	/* Wait for a free batch */
+	if (!stream->batch)
+	{
+		stream->batch = (instrBatch *)popStreamRing(&stream->freeBatches);
+	}
+
+	item = &stream->batch->instrArr[stream->batch->instrNum++];
+	setInstruction(&item->instr, line, 0, 0);
+	item->op1Name = line->op1.str;
+	item->op2Name = line->op2.str;
+	item->lineNum = line->lineNum;
+
+	if (stream->batch->instrNum == STREAM_BATCH_SIZE)
+	{
+		flushStreamBatch(stream);
+	}
+	return TRUE;
+}
+
+/* Returns a new stream state of the file (or NULL if there is no memory), and starts its threads. */
+streamState *startStream(assemblyContext *ctx, FILE *file)
+{
+	streamState *stream = (streamState *)calloc(1, sizeof(streamState));
+	int i;
+
+	if (!stream)
+	{
+		return NULL;
+	}
+
+	stream->batchesArr = (instrBatch *)malloc(STREAM_RING_SIZE * sizeof(instrBatch));
+	stream->nextChunk = newStreamChunk(NULL, 0, STREAM_CHUNK_SIZE);
+	if (!stream->batchesArr || !stream->nextChunk)
+	{
+		free(stream->batchesArr);
+		free(stream->nextChunk);
+		free(stream);
+		return NULL;
+	}
+
+	stream->ctx = ctx;
+	stream->file = file;
+	initStreamRing(&stream->chunks);
+	initStreamRing(&stream->batches);
+	initStreamRing(&stream->freeBatches);
+	for (i = 0; i < STREAM_RING_SIZE; i++)
+	{
+		stream->batchesArr[i].instrNum = 0;
+		pushStreamRing(&stream->freeBatches, &stream->batchesArr[i]);
+	}
+
+	/* Without threads, the parser reads and encodes by itself */
+	stream->hasReader = (pthread_create(&stream->reader, NULL, readChunksWorker, stream) == 0) ? TRUE : FALSE;
+	stream->hasEncoder = (pthread_create(&stream->encoder, NULL, encodeBatchesWorker, stream) == 0) ? TRUE : FALSE;
+
+	return stream;
+}
+
+/* Reads, parses and encodes the file at the same time (stream mode). */
+/* Like firstFileRead in single pass mode, but the code and the fixups are done when it returns. */
+/* Returns how many errors were found. */
+int streamFileRead(assemblyContext *ctx, FILE *file, int *IC, int *DC)
+{
+	streamState *stream;
+	streamChunk *chunk;
+	linesList lines = { 0 };
+	int errorsFound = 0;
+	bool isMemoryFull = FALSE;
+
+	stream = ctx->stream = startStream(ctx, file);
+	if (!stream)
+	{
+		printError(ctx, 0, "Not enough memory to stream the file.");
+		return 1;
+	}
+
+	/* Parse the chunks in the order of the file (after the memory is full, they are only taken out of the ring) */
+	while ((chunk = stream->hasReader ? (streamChunk *)popStreamRing(&stream->chunks) : readStreamChunk(stream)) != NULL)
+	{
+		if (stream->lastChunk)
+		{
+			stream->lastChunk->next = chunk;
+		}
+		else
+		{
+			stream->firstChunk = chunk;
+		}
+		stream->lastChunk = chunk;
+
+		if (!isMemoryFull)
+		{
+			errorsFound += firstFileRead(ctx, (char *)(chunk + 1), chunk->size, &lines, IC, DC);
+			isMemoryFull = !isBelowMemoryLimit(ctx, *IC + *DC);
+		}
+	}
+
+	/* Let the encoder finish */
+	flushStreamBatch(stream);
+	closeStreamRing(&stream->batches);
+	if (stream->hasReader)
+	{
+		pthread_join(stream->reader, NULL);
+		stream->hasReader = FALSE;
+	}
+	if (stream->hasEncoder)
+	{
+		pthread_join(stream->encoder, NULL);
+		stream->hasEncoder = FALSE;
+	}
+
+	if (stream->readFailed)
+	{
+		printError(ctx, 0, "Not enough memory for more lines. Stoping to read the file.");
+		errorsFound++;
+	}
+	if (stream->encodeFailed || stream->lines.failed)
+	{
+		printError(ctx, 0, "Not enough memory to encode the file.");
+		errorsFound++;
+	}
+
+	return errorsFound;
+}
+
+/* Returns the offset of the line of the word 'wordInd' in the lines of the object file (see appendObjectLines). */
+size_t getObjectLineOffset(int wordInd)
+{
+	size_t offset = 0;
+	long address = FIRST_ADDRESS, endOfDigits = 10, lastAddress = FIRST_ADDRESS + wordInd, count;
+	int digitsNum = 1;
+
+	/* The addresses with the same number of digits have lines of the same length */
+	while (address < lastAddress)
+	{
+		while (endOfDigits <= address)
+		{
+			endOfDigits *= 10;
+			digitsNum++;
+		}
+		count = ((endOfDigits < lastAddress) ? endOfDigits : lastAddress) - address;
+		offset += count * (1 + digitsNum + 2 + MEMORY_WORD_DIGITS);	/* "\n", the address, "\t\t" and the word */
+		address += count;
+	}
+	return offset;
+}
+
+/* Creates the .ob file from the lines which were formatted by the encoder (stream mode). */
+/* The words of the label operands are patched first, and the lines of the data are added after the code. */
+void writeStreamObjectFile(assemblyContext *ctx, char *name, int IC, int DC, int *memoryArr)
+{
+	streamState *stream = ctx->stream;
+	outputBuffer partsArr[2] = { { 0 } };
+	int i;
+
+	/* The label operands were formatted with their temporary words */
+	for (i = 0; i < ctx->fixupNum && !stream->lines.failed; i++)
+	{
+		encodeBase4Spcl(ctx->codeArr[ctx->fixupArr[i].wordInd],
+			stream->lines.data + getObjectLineOffset(ctx->fixupArr[i].wordInd + 1) - MEMORY_WORD_DIGITS);
+	}
+	appendObjectLines(&stream->arena, &stream->lines, memoryArr, IC, IC + DC);
+
+	/* The header (IC and DC) */
+	appendOutputStr(&ctx->arena, &partsArr[0], "\t\t");
+	appendOutputNum(&ctx->arena, &partsArr[0], IC);
+	appendOutputStr(&ctx->arena, &partsArr[0], "  ");
+	appendOutputNum(&ctx->arena, &partsArr[0], DC);
+	partsArr[1] = stream->lines;
+
+	writeOutputParts(ctx, name, ".ob", partsArr, 2);
+}
+
+/* Releases the stream state of the file (the threads are already done). */
+void freeStream(assemblyContext *ctx)
+{
+	streamState *stream = ctx->stream;
+	streamChunk *chunk;
+
+	if (!stream)
+	{
+		return;
+	}
+
+	while (stream->firstChunk)
+	{
+		chunk = stream->firstChunk;
+		stream->firstChunk = chunk->next;
+		free(chunk);
+	}
+	free(stream->nextChunk);
+	destroyStreamRing(&stream->chunks);
+	destroyStreamRing(&stream->batches);
+	destroyStreamRing(&stream->freeBatches);
+	arenaFree(&stream->arena);
+	free(stream->batchesArr);
+	free(stream);
+	ctx->stream = NULL;
+}
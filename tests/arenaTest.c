@@ -0,0 +1,84 @@
+/*
+Checks the memory arena of a context while it assembles a small source a few times.
+The first assembly must take all its memory from one arena block, and the next assemblies (after the arena is reset
+by clearData) must reuse it: no new blocks, and the same number of allocations as the first assembly.
+Usage: arenaTest source outDir (the source name is without ".as", see "make test")
+*/
+
+/* ======== Includes ======== */
+#include "../assembler.h"
+
+/* ======== Macros ======== */
+#define ASSEMBLIES_NUM		4
+
+/* ====== Methods ====== */
+
+int main(int argc, char *argv[])
+{
+	assemblyContext *ctx;
+	long allocsNum = 0, firstAllocsNum = 0;
+	int i, errorsNum = 0;
+
+	if (argc != 3)
+	{
+		printf("[Info] Usage: arenaTest source outDir\n");
+		return 1;
+	}
+
+	ctx = createContext();
+	if (!ctx || !(ctx->log = tmpfile()))
+	{
+		printf("[Error] Not enough memory for the context.\n");
+		return 1;
+	}
+	initBase4Table();
+	ctx->outDir = argv[2];
+
+	for (i = 0; i < ASSEMBLIES_NUM; i++)
+	{
+		parseFile(ctx, argv[1]);
+		allocsNum = ctx->arena.allocsNum - allocsNum;
+		if (i == 0)
+		{
+			firstAllocsNum = allocsNum;
+		}
+
+		if (ctx->totalStats.failedNum || ctx->totalStats.filesNum != i + 1)
+		{
+			printf("[Error] The assembly %d of \"%s.as\" failed.\n", i + 1, argv[1]);
+			errorsNum++;
+			break;
+		}
+		if (ctx->arena.blocksNum != 1)
+		{
+			printf("[Error] The assembly %d has %ld arena blocks instead of 1.\n", i + 1, ctx->arena.blocksNum);
+			errorsNum++;
+		}
+		if (allocsNum <= 0 || allocsNum != firstAllocsNum)
+		{
+			printf("[Error] The assembly %d has %ld arena allocations instead of %ld.\n", i + 1, allocsNum, firstAllocsNum);
+			errorsNum++;
+		}
+		if (ctx->arena.current)
+		{
+			printf("[Error] The arena wasn't reset after the assembly %d.\n", i + 1);
+			errorsNum++;
+		}
+		allocsNum = ctx->arena.allocsNum;
+	}
+
+	if (errorsNum)
+	{
+		printf("[Info] The messages of the assemblies:\n");
+		printLog(ctx->log, stdout);
+		ctx->log = stdout;
+	}
+	else
+	{
+		fclose(ctx->log);
+		ctx->log = stdout;
+		printf("[Info] arenaTest: %ld allocations from 1 arena block in every assembly.\n", firstAllocsNum);
+	}
+	freeContext(ctx);
+	return errorsNum ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+/*
+Checks the table-driven base 4 special encoder (encodeBase4Spcl) against the original encoder, which converted
+the word to a binary string and printed a digit for every two bits. Every 14 bit word is checked, and also the
+negative numbers of the .data directives (only their low 14 bits are encoded).
+Usage: base4Test (see "make test")
+*/
+
+/* ======== Includes ======== */
+#include "../assembler.h"
+
+/* ====== Methods ====== */
+
+/* Returns a pointer to a string representing the binary translation of a memory word (the original encoder). */
+char *Comp2Binary(int num, char *str)
+{
+	char bin_str[MEMORY_WORD_LENGTH + 1];
+	unsigned int i;
+	for (i = 0; i < MEMORY_WORD_LENGTH; i++)
+	{
+		unsigned int mask = 1u << (MEMORY_WORD_LENGTH - 1 - i);
+		bin_str[i] = (num & mask) ? '1' : '0';
+	}
+	bin_str[MEMORY_WORD_LENGTH] = '\0';
+	strcpy(str, bin_str);
+	return str;
+}
+
+/* Writes a number (a memory word) in base 4 special into word, like the original fprintfBase4Spcl. */
+void originalBase4Spcl(int num, char *word)
+{
+	unsigned int i;
+	char buffer[MEMORY_WORD_LENGTH + 1];
+	char *p = buffer;
+	p = Comp2Binary(num, p); /* translation from base 2 to base 4 spcl char's */
+
+	for (i = 0; i < strlen(p) - 1; i += 2)
+	{
+		if (p[i] == '0' && p[i + 1] == '0')
+			*word++ = '*';
+		else if (p[i] == '0' && p[i + 1] == '1')
+			*word++ = '#';
+		else if (p[i] == '1' && p[i + 1] == '0')
+			*word++ = '%';
+		else if (p[i] == '1' && p[i + 1] == '1')
+			*word++ = '!';
+	}
+	*word = '\0';
+}
+
+int main()
+{
+	char expected[MEMORY_WORD_DIGITS + 1], word[MEMORY_WORD_DIGITS + 1];
+	int num, errorsNum = 0;
+
+	initBase4Table();
+	for (num = -(1 << (MEMORY_WORD_LENGTH - 1)); num < (1 << MEMORY_WORD_LENGTH); num++)
+	{
+		originalBase4Spcl(num, expected);
+		*encodeBase4Spcl(num, word) = '\0';
+		if (strcmp(word, expected) != 0)
+		{
+			printf("[Error] %d is encoded as \"%s\" instead of \"%s\".\n", num, word, expected);
+			errorsNum++;
+		}
+	}
+
+	if (!errorsNum)
+	{
+		printf("[Info] base4Test: the table encoder is the same as the original encoder.\n");
+	}
+	return errorsNum ? 1 : 0;
+}
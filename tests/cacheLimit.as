@@ -0,0 +1,41 @@
+L1:	mov L2,r1
+L2:	jmp L8
+L3:	.data 3,-3
+L4:	mov L5,r4
+L5:	jmp L11
+L6:	.data 6,-6
+L7:	mov L8,r7
+L8:	jmp L14
+L9:	.data 9,-9
+L10:	mov L11,r2
+L11:	jmp L17
+L12:	.data 12,-12
+L13:	mov L14,r5
+L14:	jmp L20
+L15:	.data 15,-15
+L16:	mov L17,r0
+L17:	jmp L23
+L18:	.data 18,-18
+L19:	mov L20,r3
+L20:	jmp L26
+L21:	.data 21,-21
+L22:	mov L23,r6
+L23:	jmp L29
+L24:	.data 24,-24
+L25:	mov L26,r1
+L26:	jmp L32
+L27:	.data 27,-27
+L28:	mov L29,r4
+L29:	jmp L35
+L30:	.data 30,-30
+L31:	mov L32,r7
+L32:	jmp L38
+L33:	.data 33,-33
+L34:	mov L35,r2
+L35:	jmp L1
+L36:	.data 36,-36
+L37:	mov L38,r5
+L38:	jmp L4
+L39:	.data 39,-39
+L40:	mov L1,r0
+	stop
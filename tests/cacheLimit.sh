@@ -0,0 +1,72 @@
+#!/bin/sh
+# Checks that a warm --cache run prints and writes the same as a cold run near the memory limit (--max-words).
+# The cache is filled by a run without a limit (or with the file before an edit), so every line is in the cache,
+# also the lines which reach the limit. Usage: tests/cacheLimit.sh path/to/main
+
+MAIN=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+TESTS_DIR=$(cd "$(dirname "$0")" && pwd)
+WORK="$TESTS_DIR/work/cacheLimit"
+FAILED=0
+
+# Runs the assembler on the source in a directory, without the output files of the last run ("run dir options...")
+run()
+{
+	dir=$1
+	shift
+	rm -f "$dir"/cacheLimit.ob "$dir"/cacheLimit.ent "$dir"/cacheLimit.ext
+	(cd "$dir" && "$MAIN" "$@" cacheLimit > out.txt)
+}
+
+# Compares the messages and the output files of the warm and the cold runs ("compare name")
+compare()
+{
+	for file in out.txt cacheLimit.ob cacheLimit.ent cacheLimit.ext
+	do
+		if [ -f "$WORK/cold/$file" ] || [ -f "$WORK/warm/$file" ]
+		then
+			if ! cmp -s "$WORK/cold/$file" "$WORK/warm/$file"
+			then
+				echo "[Error] $1: $file of the warm run differs from the cold run."
+				FAILED=1
+			fi
+		fi
+	done
+}
+
+# Starts a test with a new copy of the source in both directories
+reset()
+{
+	rm -rf "$WORK"
+	mkdir -p "$WORK/cold" "$WORK/warm"
+	cp "$TESTS_DIR/cacheLimit.as" "$WORK/cold/cacheLimit.as"
+	cp "$TESTS_DIR/cacheLimit.as" "$WORK/warm/cacheLimit.as"
+}
+
+for mode in "" --single-pass
+do
+	# The cache of a run without a limit, replayed with a limit
+	for limit in 20 37 50 63 64 65 80
+	do
+		reset
+		run "$WORK/warm" --cache $mode
+		run "$WORK/warm" --cache $mode --max-words $limit
+		run "$WORK/cold" $mode --max-words $limit
+		compare "--max-words $limit $mode"
+	done
+
+	# A warm run after an edit of one line, which moves the limit to other lines
+	reset
+	run "$WORK/warm" --cache $mode --max-words 64
+	sed 's/^L2:	jmp L8$/L2:	.data 1/' "$TESTS_DIR/cacheLimit.as" > "$WORK/warm/cacheLimit.as"
+	cp "$WORK/warm/cacheLimit.as" "$WORK/cold/cacheLimit.as"
+	run "$WORK/warm" --cache $mode --max-words 64
+	run "$WORK/cold" $mode --max-words 64
+	compare "edit of a line $mode"
+done
+
+rm -rf "$WORK"
+if [ $FAILED -eq 0 ]
+then
+	echo "[Info] cacheLimit: the warm and the cold runs are the same."
+fi
+exit $FAILED
@@ -0,0 +1,17 @@
+; A source for tests/imasmTest.c, with entries, externs, data and macros
+.define len = 3
+.extern PRINT
+.extern COUNT
+.entry MAIN
+MAIN:	mov #len,r1
+LOOP:	add ARR[2],r3
+		jsr PRINT
+		cmp COUNT,#-5
+		bne LOOP
+		lea MSG,r6
+		inc COUNT
+		stop
+.entry ARR
+ARR:	.data 7,-12,len,8191
+MSG:	.string "hi there"
+.entry MSG
@@ -0,0 +1,259 @@
+/*
+Checks the library (imasm.h) against the command line: a source is assembled in memory, and its memory words,
+entries and externs must be the same as the output files of the command line for the same source.
+It also checks the severity and the line of the diagnostics of a source with errors, and that buffers which are
+too small get IMASM_TRUNCATED with the full numbers.
+Usage: imasmTest source outDir (the source name is without ".as", and outDir has its files, see "make test")
+*/
+
+/* ======== Includes ======== */
+#include "../assembler.h"
+#include "../imasm.h"
+#include <stdlib.h>
+
+/* ======== Macros ======== */
+#define WORDS_SIZE			4096
+#define SYMBOLS_SIZE		64
+#define DIAGNOSTICS_SIZE	16
+#define PATH_SIZE			512
+
+/* ====== Data Structures ====== */
+
+/* A source with a warning, an error of the first read and an error of the second read */
+const char g_errorsSource[] =
+	"MAIN:\tmov r1,r2\n"
+	"X:\t.extern Y\n"
+	"\tjmp NOWHERE\n"
+	"\tmov #zz,r1\n"
+	"\tstop\n";
+
+/* The diagnostics of g_errorsSource, in the order the assembler prints them */
+const imasmDiagnostic g_errorsDiagnostics[] =
+{
+	{ IMASM_WARNING, 2, "The assembler ignored the label before the directive." },
+	{ IMASM_ERROR, 4, "\"zz\" isn't a valid number." },
+	{ IMASM_ERROR, 3, "No such label as \"NOWHERE\"" }
+};
+
+/* ====== Methods ====== */
+
+/* Reads the whole file into a malloc block, and sets its size. Returns NULL if it failed. */
+char *readWholeFile(char *fileName, size_t *size)
+{
+	FILE *file = fopen(fileName, "rb");
+	char *text = NULL;
+	long length;
+
+	if (file && fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0 &&
+		(text = (char *)malloc(length + 1)) && fread(text, 1, length, file) == (size_t)length)
+	{
+		*size = length;
+	}
+	else
+	{
+		free(text);
+		text = NULL;
+	}
+	if (file)
+	{
+		fclose(file);
+	}
+	return text;
+}
+
+/* Opens an output file of the command line ("outDir/name.ending"). */
+FILE *openOutput(char *outDir, char *source, char *ending)
+{
+	char path[PATH_SIZE], *name = strrchr(source, '/');
+
+	sprintf(path, "%.200s/%.200s%s", outDir, name ? name + 1 : source, ending);
+	return fopen(path, "r");
+}
+
+/* Compares the memory words of the result with the .ob file. Returns how many errors were found. */
+int checkObject(imasmResult *result, FILE *file)
+{
+	char word[MEMORY_WORD_DIGITS + 1], expected[MEMORY_WORD_DIGITS + 1];
+	int IC, DC, address, i = 0;
+
+	if (!file || fscanf(file, "%d %d", &IC, &DC) != 2 || IC != result->IC || DC != result->DC)
+	{
+		printf("[Error] The IC and DC of the library (%d %d) aren't the ones of the .ob file.\n", result->IC, result->DC);
+		return 1;
+	}
+	for (; fscanf(file, "%d %7s", &address, expected) == 2; i++)
+	{
+		*encodeBase4Spcl(result->words[i], word) = '\0';
+		if (i >= IC + DC || address != IMASM_FIRST_ADDRESS + i || strcmp(word, expected) != 0)
+		{
+			printf("[Error] The word %d of the library (%s) isn't the one of the .ob file (%s).\n", i, word, expected);
+			return 1;
+		}
+	}
+	if (i != IC + DC)
+	{
+		printf("[Error] The .ob file has %d words instead of %d.\n", i, IC + DC);
+		return 1;
+	}
+	return 0;
+}
+
+/* Compares the symbols of the result with the .ent or .ext file. Returns how many errors were found. */
+int checkSymbols(imasmSymbol *symbolsArr, int symbolsNum, FILE *file, char *ending)
+{
+	char name[MAX_LABEL_LENGTH + 1];
+	int address, i = 0;
+
+	for (; file && fscanf(file, "%30s %d", name, &address) == 2; i++)
+	{
+		if (i >= symbolsNum || strcmp(symbolsArr[i].name, name) != 0 || symbolsArr[i].address != address)
+		{
+			printf("[Error] The symbol %d of the library isn't \"%s %d\" of the %s file.\n", i, name, address, ending);
+			return 1;
+		}
+	}
+	if (i != symbolsNum)
+	{
+		printf("[Error] The %s file has %d symbols instead of %d.\n", ending, i, symbolsNum);
+		return 1;
+	}
+	return 0;
+}
+
+/* Assembles the source again with buffers of one item, and checks the status, the numbers and the first items. */
+int checkTruncated(imasmContext *asmCtx, char *source, size_t sourceSize, imasmResult *full)
+{
+	int word;
+	imasmSymbol entry, externSymbol;
+	imasmResult result = { 0 };
+	imasmStatus status;
+
+	result.words = &word;
+	result.wordsSize = 1;
+	result.entries = &entry;
+	result.entriesSize = 1;
+	result.externs = &externSymbol;
+	result.externsSize = 1;
+	status = imasmAssemble(asmCtx, source, sourceSize, NULL, &result);
+
+	if (status != IMASM_TRUNCATED || result.IC != full->IC || result.DC != full->DC ||
+		result.entriesNum != full->entriesNum || result.externsNum != full->externsNum)
+	{
+		printf("[Error] Small buffers got the status %d (IC %d, DC %d, %d entries, %d externs).\n", status, result.IC,
+			result.DC, result.entriesNum, result.externsNum);
+		return 1;
+	}
+	if (word != full->words[0] || strcmp(entry.name, full->entries[0].name) != 0 ||
+		strcmp(externSymbol.name, full->externs[0].name) != 0)
+	{
+		printf("[Error] The first items of the small buffers aren't the first items of the full buffers.\n");
+		return 1;
+	}
+	return 0;
+}
+
+/* Assembles g_errorsSource, and checks its status and its diagnostics. Returns how many errors were found. */
+int checkDiagnostics(imasmContext *asmCtx)
+{
+	int expectedNum = sizeof(g_errorsDiagnostics) / sizeof(imasmDiagnostic), i, errorsNum = 0;
+	imasmDiagnostic diagnostics[DIAGNOSTICS_SIZE];
+	imasmResult result = { 0 };
+	imasmStatus status;
+
+	result.diagnostics = diagnostics;
+	result.diagnosticsSize = DIAGNOSTICS_SIZE;
+	status = imasmAssemble(asmCtx, g_errorsSource, strlen(g_errorsSource), NULL, &result);
+
+	if (status != IMASM_ERRORS || result.errorsNum != 2 || result.diagnosticsNum != expectedNum)
+	{
+		printf("[Error] The errors source got the status %d with %d errors and %d diagnostics.\n", status,
+			result.errorsNum, result.diagnosticsNum);
+		return 1;
+	}
+	for (i = 0; i < expectedNum; i++)
+	{
+		if (diagnostics[i].severity != g_errorsDiagnostics[i].severity ||
+			diagnostics[i].lineNum != g_errorsDiagnostics[i].lineNum ||
+			strcmp(diagnostics[i].text, g_errorsDiagnostics[i].text) != 0)
+		{
+			printf("[Error] The diagnostic %d is %d at line %d: %s\n", i, diagnostics[i].severity, diagnostics[i].lineNum,
+				diagnostics[i].text);
+			errorsNum++;
+		}
+	}
+	return errorsNum;
+}
+
+int main(int argc, char *argv[])
+{
+	imasmContext *asmCtx;
+	imasmResult result = { 0 };
+	imasmStatus status;
+	static int words[WORDS_SIZE];
+	static imasmSymbol entries[SYMBOLS_SIZE], externs[SYMBOLS_SIZE];
+	char path[PATH_SIZE], *source;
+	size_t sourceSize;
+	FILE *file;
+	int errorsNum = 0;
+
+	if (argc != 3)
+	{
+		printf("[Info] Usage: imasmTest source outDir\n");
+		return 1;
+	}
+	sprintf(path, "%.500s.as", argv[1]);
+	source = readWholeFile(path, &sourceSize);
+	asmCtx = imasmCreate();
+	if (!source || !asmCtx)
+	{
+		printf("[Error] Can't read the file \"%s\".\n", path);
+		return 1;
+	}
+	initBase4Table();
+
+	/* The source with buffers which are big enough */
+	result.words = words;
+	result.wordsSize = WORDS_SIZE;
+	result.entries = entries;
+	result.entriesSize = SYMBOLS_SIZE;
+	result.externs = externs;
+	result.externsSize = SYMBOLS_SIZE;
+	status = imasmAssemble(asmCtx, source, sourceSize, NULL, &result);
+	if (status != IMASM_OK || !result.entriesNum || !result.externsNum)
+	{
+		printf("[Error] \"%s\" got the status %d with %d errors.\n", path, status, result.errorsNum);
+		errorsNum++;
+	}
+	else
+	{
+		file = openOutput(argv[2], argv[1], ".ob");
+		errorsNum += checkObject(&result, file);
+		if (file)
+		{
+			fclose(file);
+		}
+		file = openOutput(argv[2], argv[1], ".ent");
+		errorsNum += checkSymbols(entries, result.entriesNum, file, ".ent");
+		if (file)
+		{
+			fclose(file);
+		}
+		file = openOutput(argv[2], argv[1], ".ext");
+		errorsNum += checkSymbols(externs, result.externsNum, file, ".ext");
+		if (file)
+		{
+			fclose(file);
+		}
+		errorsNum += checkTruncated(asmCtx, source, sourceSize, &result);
+	}
+
+	errorsNum += checkDiagnostics(asmCtx);
+
+	if (!errorsNum)
+	{
+		printf("[Info] imasmTest: the library is the same as the command line.\n");
+	}
+	imasmFree(asmCtx);
+	free(source);
+	return errorsNum ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+#!/bin/sh
+# Checks that the parallel first read (--threads) prints and writes the same as the sequential read.
+# The sources are generated here, with 20000 lines, so they are cut into a few chunks (see MIN_CHUNK_LINES).
+# "clean" assembles: its chunks use labels, entries and externs of other chunks (joined with their IC and DC shifted),
+# and one chunk uses a macro which is defined in an earlier chunk (so the chunk is read again).
+# "errors" has a label which is defined in two chunks, a macro which is used before its definition in a later chunk,
+# and a label which is an .entry in two chunks. Usage: tests/parallelRead.sh path/to/main
+
+MAIN=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+TESTS_DIR=$(cd "$(dirname "$0")" && pwd)
+WORK="$TESTS_DIR/work/parallelRead"
+LINES_NUM=20000
+FAILED=0
+
+# Writes a source of LINES_NUM lines ("generate isErrors"). Every line N gets the label LN, and the special lines
+# are at the same places in both sources.
+generate()
+{
+	awk -v linesNum=$LINES_NUM -v isErrors=$1 'BEGIN {
+		print ".extern OUT"
+		print ".define size = 3"
+		for (i = 3; i <= linesNum; i++)
+		{
+			if (i == 1000 && isErrors)
+				print "\tmov #late,r1"
+			else if (i == 1500 && isErrors)
+				print "DUP:\tinc r2"
+			else if (i == 7000)
+				print ".entry L" (i + 1)
+			else if (i == 8000)
+				print ".define mid = 7"
+			else if (i == 13000)
+				print "\tprn #mid"
+			else if (i == 13500 && isErrors)
+				print "DUP:\tdec r3"
+			else if (i == 14000 && isErrors)
+				print ".define late = 5"
+			else if (i == 17000 && isErrors)
+				print ".entry L7001"
+			else if (i == linesNum)
+				print "\tstop"
+			else if (i % 5 == 0)
+				print "L" i ":\t.data " (i % 1000) ",-" (i % 100) ",size"
+			else if (i % 5 == 1)
+			{
+				# A command line of another chunk (the lines which are 1 mod 5)
+				for (j = (i * 7919) % (linesNum - 20); j % 5 != 1 || j < 10; j++);
+				print "L" i ":\tmov L" j ",r" (i % 8)
+			}
+			else if (i % 5 == 2)
+				print "L" i ":\tjmp OUT"
+			else if (i % 5 == 3)
+				print "L" i ":\tcmp #size,L" (i > 10 ? i - 2 : i + 3) "[size]"
+			else if (i % 97 < 5 && i > 10)
+				print ".entry L" (i - 3)
+			else
+				print "L" i ":\t.string \"s" i "\""
+		}
+	}'
+}
+
+# Runs the assembler on a source in a directory ("run dir name options...")
+run()
+{
+	dir=$1
+	name=$2
+	shift 2
+	rm -f "$dir/$name.ob" "$dir/$name.ent" "$dir/$name.ext"
+	(cd "$dir" && "$MAIN" --max-words 0 "$@" "$name" > "$name.txt")
+}
+
+# Compares the messages and the output files of the sequential and the parallel reads ("compare name title")
+compare()
+{
+	for ending in txt ob ent ext
+	do
+		if [ -f "$WORK/sequential/$1.$ending" ] || [ -f "$WORK/parallel/$1.$ending" ]
+		then
+			if ! cmp -s "$WORK/sequential/$1.$ending" "$WORK/parallel/$1.$ending"
+			then
+				echo "[Error] $2: $1.$ending of the parallel read differs from the sequential read."
+				FAILED=1
+			fi
+		fi
+	done
+}
+
+rm -rf "$WORK"
+mkdir -p "$WORK/sequential" "$WORK/parallel"
+generate 0 > "$WORK/sequential/clean.as"
+generate 1 > "$WORK/sequential/errors.as"
+cp "$WORK/sequential/clean.as" "$WORK/sequential/errors.as" "$WORK/parallel"
+
+for name in clean errors
+do
+	run "$WORK/sequential" $name
+	for threads in 2 4
+	do
+		run "$WORK/parallel" $name --threads $threads
+		compare $name "--threads $threads"
+	done
+done
+
+# The clean source must assemble, and the errors source must have its errors
+if [ ! -f "$WORK/sequential/clean.ob" ] || [ -f "$WORK/sequential/errors.ob" ]
+then
+	echo "[Error] The generated sources didn't assemble as expected."
+	FAILED=1
+fi
+
+if [ $FAILED -eq 0 ]
+then
+	rm -rf "$WORK"
+	echo "[Info] parallelRead: the parallel and the sequential reads are the same."
+fi
+exit $FAILED
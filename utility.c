@@ -1,431 +1,953 @@
-/*
-This file contains utility parsing/non parsing functions, that going to be at use in firstRead.
-*/
-
-
-/* ======== Includes ======== */
-#include "assembler.h"
-#include <ctype.h>
-#include <stdlib.h>
-
-/* ====== Methods ====== */
-extern const command g_cmdArr[];
-extern labelInfo g_labelArr[];
-extern int g_labelNum;
-lineInfo *g_entryLines[MAX_LABELS_NUM];
-extern int g_entryLabelsNum;
-extern macro g_macroArr[MAX_LABELS_NUM];
-extern int macroArrInd;
-
-/*Returns a pointer to the macro with 'macroName' name in g_macroArr or NULL if there isn't such macro. */
-macro *getMacro(char *macroName)
-{
-	int i = 0;
-
-	if (macroName)
-	{
-		for (i = 0; i < macroArrInd; i++)
-		{
-			if (strcmp(macroName, g_macroArr[i].name) == 0)
-			{
-				return &g_macroArr[i];
-			}
-		}
-	}
-	return NULL;
-}
-/* Returns a pointer to the label with 'labelName' name in g_labelArr or NULL if there isn't such label. */
-labelInfo *getLabel(char *labelName)
-{
-	int i = 0;
-
-	if (labelName)
-	{
-		for (i = 0; i < g_labelNum; i++)
-		{
-			if (strcmp(labelName, g_labelArr[i].name) == 0)
-			{
-				return &g_labelArr[i];
-			}
-		}
-	}
-	return NULL;
-}
-
-/* Returns the macro value and save the value inside 'val' */
-int *getMacroValue(macro *mac,int *val)
-{
-	val = &(mac->value);
-		return val;
-}
-/* Returns the address of the 'operand'  */
-int getAddressValue(operandInfo *operand)
-{
-	int add = operand->address;
-		return add;
-}
-/* Return the value inside the Index 'operand' */
-int getIndexValue(operandInfo *operand)
-{
-	int val = operand->indexVal;
-		return val;
-}
-
-/* Returns the ID of the command with 'cmdName' name in g_cmdArr or -1 if there isn't such command. */
-int getCmdId(char *cmdName)
-{
-	int i = 0;
-
-	while (g_cmdArr[i].name)
-	{
-		if (strcmp(cmdName, g_cmdArr[i].name) == 0)
-		{
-			return i;
-		}
-
-		i++;
-	}
-	return -1;
-}
-
-/* Returns a pointer to the start of first token. */
-/* Also makes *endOfTok (if it's not NULL) to point at the last char after the token. */
-char *getFirstTok(char *str, char **endOfTok)
-{
-	char *tokStart = str;
-	char *tokEnd = NULL;
-
-	/* Trim the start */
-	trimLeftStr(&tokStart);
-
-	/* Find the end of the first word */
-	tokEnd = tokStart;
-	while (*tokEnd != '\0' && !isspace(*tokEnd))
-	{
-		tokEnd++;
-	}
-
-	/* Add \0 at the end if needed */
-	if (*tokEnd != '\0')
-	{
-		*tokEnd = '\0';
-		tokEnd++;
-	}
-
-	/* Make *endOfTok (if it's not NULL) to point at the last char after the token */
-	if (endOfTok)
-	{
-		*endOfTok = tokEnd;
-	}
-	return tokStart;
-}
-/* Removes spaces from start */
-void trimLeftStr(char **ptStr)
-{
-	/* Return if it's NULL */
-	if (!ptStr)
-	{
-		return;
-	}
-
-	/* Get ptStr to the start of the actual text */
-	while (isspace(**ptStr))
-	{
-		++*ptStr;
-	}
-}
-/* Returns a pointer to the start of the first operand in 'line' and change the end of it to '\0'. */
-/* Also makes *endOfOp (if it's not NULL) point at the next char after the operand. */
-char *getFirstOperand(char *line, char **endOfOp, bool *foundComma)
-{
-	if (!isWhiteSpaces(line))
-	{
-		/* Find the first comma */
-		char *end = strchr(line, ',');
-		if (end)
-		{
-			*foundComma = TRUE;
-			*end = '\0';
-			end++;
-		}
-		else
-		{
-			*foundComma = FALSE;
-		}
-
-		/* Set endOfOp (if it's not NULL) to point at the next char after the operand
-		(Or at the end of it if it's the end of the line) */
-		if (endOfOp)
-		{
-			if (end)
-			{
-				*endOfOp = end;
-			}
-			else
-			{
-				*endOfOp = strchr(line, '\0');
-			}
-		}
-	}
-
-	trimStr(&line);
-	return line;
-}
-
-/* Removes all the spaces from the edges of the string ptStr is pointing to. */
-void trimStr(char **ptStr)
-{
-	char *eos;
-
-	/* Return if it's NULL or empty string */
-	if (!ptStr || **ptStr == '\0')
-	{
-		return;
-	}
-
-	trimLeftStr(ptStr);
-
-	/* oes is pointing to the last char in str, before '\0' */
-	eos = *ptStr + strlen(*ptStr) - 1;
-
-	/* Remove spces from the end */
-	while (isspace(*eos) && eos != *ptStr)
-	{
-		*eos-- = '\0';
-	}
-}
-
-/* Returns if str contains only one word. */
-bool isOneWord(char *str)
-{
-	trimLeftStr(&str);							/* Skip the spaces at the start */
-	while (!isspace(*str) && *str) { str++; }	/* Skip the text at the middle */					
-
-	/* Return if it's the end of the text or not. */
-	return isWhiteSpaces(str);
-}
-
-/* Returns if str contains only white spaces. */
-bool isWhiteSpaces(char *str)
-{
-	while (*str)
-	{
-		if (!isspace(*str++))
-		{
-			return FALSE;
-		}
-	}
-	return TRUE;
-}
-
-/* Returns if labelStr is a legal label name. */
-bool isLegalLabel(char *labelStr, int lineNum, bool printErrors)
-{
-	int labelLength = strlen(labelStr), i;
-
-	/* Check if the label is short enough */
-	if (strlen(labelStr) > MAX_LABEL_LENGTH)
-	{
-		if (printErrors) printError(lineNum, "Label is too long. Max label name length is %d.", MAX_LABEL_LENGTH);
-		return FALSE;
-	}
-
-	/* Check if the label isn't an empty string */
-	if (*labelStr == '\0')
-	{
-		if (printErrors) printError(lineNum, "Label name is empty.");
-		return FALSE;
-	}
-
-	/* Check if the 1st char is a letter. */
-	if (isspace(*labelStr))
-	{
-		if (printErrors) printError(lineNum, "Label must start at the start of the line.");
-		return FALSE;
-	}
-
-	/* Check if it's chars only. */
-	for (i = 1; i < labelLength; i++)
-	{
-		if (!isalnum(labelStr[i]))
-		{
-			if (printErrors) printError(lineNum, "\"%s\" is illegal label - use letters and numbers only.", labelStr);
-			return FALSE;
-		}
-	}
-
-	/* Check if the 1st char is a letter. */
-	if (!isalpha(*labelStr))
-	{
-		if (printErrors) printError(lineNum, "\"%s\" is illegal label - first char must be a letter.", labelStr);
-		return FALSE;
-	}
-
-	/* Check if it's not a name of a register */
-	if (isRegister(labelStr, NULL)) /* NULL since we don't have to save the register number */
-	{
-		if (printErrors) printError(lineNum, "\"%s\" is illegal label - don't use a name of a register.", labelStr);
-		return FALSE;
-	}
-
-	/* Check if it's not a name of a command */
-	if (getCmdId(labelStr) != -1)
-	{
-		if (printErrors) printError(lineNum, "\"%s\" is illegal label - don't use a name of a command.", labelStr);
-		return FALSE;
-	}
-
-	return TRUE;
-}
-
-/* Returns if the label exists. */
-bool isExistingLabel(char *label)
-{
-	if (getLabel(label))
-	{
-		return TRUE;
-	}
-
-	return FALSE;
-}
-bool isExistingMacro(char *macro)
-{
-	if(getMacro(macro))
-		return TRUE;
-return FALSE;
-
-}
-/* Returns if the label is already in the entry lines array. */
-bool isExistingEntryLabel(char *labelName)
-{
-	int i = 0;
-
-	if (labelName)
-	{
-		for (i = 0; i < g_entryLabelsNum; i++)
-		{
-			if (strcmp(labelName, g_entryLines[i]->lineStr) == 0)
-			{
-				return TRUE;
-			}
-		}
-	}
-	return FALSE;
-}
-
-/* Returns if str is a register name, and update value to be the register value. */
-bool isRegister(char *str, int *value)
-{
-	if (str[0] == 'r'  && str[1] >= '0' && str[1] - '0' <= MAX_REGISTER_DIGIT && str[2] == '\0') 
-	{
-		/* Update value if it's not NULL */
-		if (value)
-		{
-			*value = str[1] - '0'; /* -'0' To get the actual number the char represents */
-		}
-		return TRUE;
-	}
-
-	return FALSE;
-}
-
-/* Return a bool, represent whether 'line' is a comment or not. */
-/* If the first char is ';' but it's not at the start of the line, it returns true and update line->isError to be TRUE. */
-bool isCommentOrEmpty(lineInfo *line)
-{
-	char *startOfText = line->lineStr; /* We don't want to change line->lineStr */
-
-	if (*line->lineStr == ';')
-	{
-		/* Comment */
-		return TRUE;
-	}
-
-	trimLeftStr(&startOfText);
-	if (*startOfText == '\0')
-	{
-		/* Empty line */
-		return TRUE;
-	}
-	if (*startOfText == ';')
-	{
-		/* Illegal comment - ';' isn't at the start of the line */
-		printError(line->lineNum, "Comments must start with ';' at the start of the line.");
-		line->isError = TRUE;
-		return TRUE;
-	}
-
-	/* Not empty or comment */
-	return FALSE;
-}
-
-
-/* Returns if the cmd is a directive. */
-bool isDirective(char *cmd)
-{
-	return ((*cmd == '.') && ( *(cmd+1) == 'd' || *(cmd+1)=='s' || *(cmd+1) == 'e' ) && (*(cmd+2) != 'e')) ? TRUE : FALSE;
-}
-/* Returns 'true' if the line is a MACRO. */
-bool isMacro(char *cmd)
-{
-	return ((*cmd == '.') && (*(cmd+1) == 'd') && (*(cmd+2) == 'e')) ? TRUE : FALSE; 
-}
-
-
-/* Returns if the strParam is a legal string param (enclosed in quotes), and remove the quotes. */
-bool isLegalStringParam(char **strParam, int lineNum)
-{
-	/* check if the string param is enclosed in quotes */
-	if ((*strParam)[0] == '"' && (*strParam)[strlen(*strParam) - 1] == '"')
-	{
-		/* remove the quotes */
-		(*strParam)[strlen(*strParam) - 1] = '\0';
-		++*strParam;
-		return TRUE;
-	}
-
-	if (**strParam == '\0')
-	{
-		printError(lineNum, "No parameter.");
-	}
-	else
-	{
-		printError(lineNum, "The parameter for .string must be enclosed in quotes.");
-	}
-	return FALSE;
-}
-
-
-/* Returns if the num is a legal number param, and save it's value in *value. */
-bool isLegalNum(char *numStr, int numOfBits, int lineNum, int *value)
-{
-	char *endOfNum;
-	/* maxNum is the max number you can represent with (MAX_LABEL_LENGTH - 1) bits 
-	 (-1 for the negative/positive bit) */
-	int maxNum = (1 << numOfBits) - 1;
-
-	if (isWhiteSpaces(numStr))
-	{
-		printError(lineNum, "Empty parameter.");
-		return FALSE;
-	}
-
-	*value = strtol(numStr, &endOfNum, 0);
-
-	/* Check if endOfNum is at the end of the string */
-	if (*endOfNum)
-	{
-		printError(lineNum, "\"%s\" isn't a valid number.", numStr);
-		return FALSE;
-	}
-
-	/* Check if the number is small enough to fit into 1 memory word 
-	(if the absolute value of number is smaller than 'maxNum' */
-	if (*value > maxNum || *value < -maxNum)
-	{
-		printError(lineNum, "\"%s\" is too %s, must be between %d and %d.", numStr, (*value > 0) ? "big" : "small", -maxNum, maxNum);
-		return FALSE;
-	}
-
-	return TRUE;
-}
+/*
+This file contains utility parsing/non parsing functions, that going to be at use in firstRead.
+*/
+
+
+/* ======== Includes ======== */
+#include "assembler.h"
+#include "reservedHash.h"
+#include <ctype.h>
+#include <stdlib.h>
+
+/* ====== Methods ====== */
+extern const command g_cmdArr[];
+
+/* Returns the hash of 'name' (FNV-1a). Never returns 0, since 0 represent an empty slot. */
+unsigned int getNameHash(const char *name)
+{
+	unsigned int hash = 2166136261u;
+
+	while (*name)
+	{
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619u;
+	}
+
+	return hash ? hash : 1;
+}
+
+/* Puts the hash and the array index in the first empty slot of the chain (without growing the index). */
+void insertHashSlot(hashIndex *index, unsigned int hash, int arrIndex)
+{
+	unsigned int i = hash & (index->size - 1);
+
+	while (index->slots[i].hash)
+	{
+		i = (i + 1) & (index->size - 1);
+	}
+
+	index->slots[i].hash = hash;
+	index->slots[i].index = arrIndex;
+	index->count++;
+}
+
+/* Adds 'arrIndex' to the index under 'hash', and grows the index if it's half full. Returns if it succeeded. */
+bool addToHashIndex(hashIndex *index, unsigned int hash, int arrIndex)
+{
+	/* Keep the index at most half full, so the chains (and the negative lookups) stay short */
+	if ((unsigned int)(index->count + 1) * 2 > index->size)
+	{
+		hashIndex newIndex;
+		unsigned int i;
+
+		newIndex.size = index->size ? index->size * 2 : MIN_HASH_SIZE;
+		newIndex.count = 0;
+		newIndex.slots = (hashSlot *)calloc(newIndex.size, sizeof(hashSlot));
+		if (!newIndex.slots)
+		{
+			return FALSE;
+		}
+
+		/* Move all the old slots into the new index */
+		for (i = 0; i < index->size; i++)
+		{
+			if (index->slots[i].hash)
+			{
+				insertHashSlot(&newIndex, index->slots[i].hash, index->slots[i].index);
+			}
+		}
+
+		free(index->slots);
+		*index = newIndex;
+	}
+
+	insertHashSlot(index, hash, arrIndex);
+	return TRUE;
+}
+
+/* Removes 'arrIndex' (that was added under 'hash') from the index. */
+void removeFromHashIndex(hashIndex *index, unsigned int hash, int arrIndex)
+{
+	unsigned int mask = index->size - 1, i, j, home;
+
+	if (!index->count)
+	{
+		return;
+	}
+
+	/* Find the slot of arrIndex */
+	for (i = hash & mask; index->slots[i].hash; i = (i + 1) & mask)
+	{
+		if (index->slots[i].index == arrIndex)
+		{
+			break;
+		}
+	}
+	if (!index->slots[i].hash)
+	{
+		return;
+	}
+
+	/* Shift back the rest of the chain, so no other slot gets unreachable */
+	for (j = (i + 1) & mask; index->slots[j].hash; j = (j + 1) & mask)
+	{
+		home = index->slots[j].hash & mask;
+
+		/* Skip slots which their home is cyclically between i (exclusive) and j (inclusive) */
+		if ((i <= j) ? (i < home && home <= j) : (i < home || home <= j))
+		{
+			continue;
+		}
+
+		index->slots[i] = index->slots[j];
+		i = j;
+	}
+
+	index->slots[i].hash = 0;
+	index->count--;
+}
+
+/* Returns if a name with 'hash' is in the index, with an array index of at least 'firstIndex'. */
+bool isHashInIndex(hashIndex *index, unsigned int hash, int firstIndex)
+{
+	unsigned int mask = index->size - 1, i;
+
+	if (!index->count)
+	{
+		return FALSE;
+	}
+
+	for (i = hash & mask; index->slots[i].hash; i = (i + 1) & mask)
+	{
+		if (index->slots[i].hash == hash && index->slots[i].index >= firstIndex)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* Makes 'dest' a copy of the index 'src'. Returns "FALSE" if there is no memory. */
+bool copyHashIndex(hashIndex *dest, hashIndex *src)
+{
+	if (dest->size != src->size)
+	{
+		hashSlot *slots = (hashSlot *)malloc(src->size * sizeof(hashSlot));
+
+		if (src->size && !slots)
+		{
+			return FALSE;
+		}
+		free(dest->slots);
+		dest->slots = slots;
+		dest->size = src->size;
+	}
+
+	if (src->size)
+	{
+		memcpy(dest->slots, src->slots, src->size * sizeof(hashSlot));
+	}
+	dest->count = src->count;
+	return TRUE;
+}
+
+/* Keeps a lookup of a name in ctx->lookupArr (a chunk of a parallel read, see parallelRead.c). */
+void keepLookup(assemblyContext *ctx, unsigned int hash, lookupKind kind)
+{
+	if (!growArray((void **)&ctx->lookupArr, &ctx->lookupArrSize, ctx->lookupNum, sizeof(symbolLookup)))
+	{
+		ctx->lookupsFailed = TRUE;
+		return;
+	}
+
+	ctx->lookupArr[ctx->lookupNum].hash = hash;
+	ctx->lookupArr[ctx->lookupNum].kind = kind;
+	ctx->lookupNum++;
+}
+
+/* Removes all the slots from the index (keeps the allocated slots for later use). */
+/* An index which is much bigger than its items need is freed instead (it grows again when needed), */
+/* so clearing it costs about the number of its items, and not the size of the biggest file it had. */
+void clearHashIndex(hashIndex *index)
+{
+	if (!index->count)
+	{
+		return;
+	}
+
+	if (index->size > MIN_HASH_SIZE && (unsigned int)index->count * HASH_SHRINK_RATIO < index->size)
+	{
+		freeHashIndex(index);
+		return;
+	}
+
+	memset(index->slots, 0, index->size * sizeof(hashSlot));
+	index->count = 0;
+}
+
+/* Frees the slots of the index. */
+void freeHashIndex(hashIndex *index)
+{
+	free(index->slots);
+	index->slots = NULL;
+	index->size = 0;
+	index->count = 0;
+}
+
+/* Returns 'size' rounded up to the strictest alignment of the basic types. */
+size_t getAlignedSize(size_t size)
+{
+	typedef union { long l; double d; void *p; } maxAlign;
+
+	return (size + sizeof(maxAlign) - 1) / sizeof(maxAlign) * sizeof(maxAlign);
+}
+
+/* Returns a pointer to the first byte after the header of the block. */
+char *getBlockData(arenaBlock *block)
+{
+	return (char *)block + getAlignedSize(sizeof(arenaBlock));
+}
+
+/* Returns 'size' bytes from the arena (or NULL if malloc failed). */
+/* The memory is valid until the next arenaReset. */
+void *arenaAlloc(memoryArena *arena, size_t size)
+{
+	arenaBlock *block = arena->current;
+	void *ptr;
+
+	size = getAlignedSize(size);
+
+	/* Move to the next block if there isn't enough space in the current one */
+	if (!block || block->used + size > block->size)
+	{
+		arenaBlock *next = block ? block->next : arena->first;
+
+		/* Add a new block after the current one if the next block is missing or too small */
+		if (!next || next->size < size)
+		{
+			size_t blockSize = (size > ARENA_BLOCK_SIZE) ? size : ARENA_BLOCK_SIZE;
+			arenaBlock *newBlock = (arenaBlock *)malloc(getAlignedSize(sizeof(arenaBlock)) + blockSize);
+
+			if (!newBlock)
+			{
+				return NULL;
+			}
+			newBlock->size = blockSize;
+			newBlock->next = next;
+			if (block)
+			{
+				block->next = newBlock;
+			}
+			else
+			{
+				arena->first = newBlock;
+			}
+			arena->blocksNum++;
+			next = newBlock;
+		}
+
+		next->used = 0;
+		block = arena->current = next;
+	}
+
+	ptr = getBlockData(block) + block->used;
+	block->used += size;
+	arena->allocsNum++;
+	return ptr;
+}
+
+/* Changes the size of 'ptr' (from the arena) to 'newSize', and returns its new place (or NULL if malloc failed). */
+/* If ptr is the last allocation and there is enough space it grows in place, otherwise it's copied. */
+void *arenaGrow(memoryArena *arena, void *ptr, size_t oldSize, size_t newSize)
+{
+	arenaBlock *block = arena->current;
+	void *newPtr;
+
+	if (!ptr)
+	{
+		return arenaAlloc(arena, newSize);
+	}
+
+	/* Grow in place */
+	oldSize = getAlignedSize(oldSize);
+	if (block && (char *)ptr + oldSize == getBlockData(block) + block->used &&
+		block->used - oldSize + getAlignedSize(newSize) <= block->size)
+	{
+		block->used = block->used - oldSize + getAlignedSize(newSize);
+		return ptr;
+	}
+
+	/* Copy to a new place */
+	newPtr = arenaAlloc(arena, newSize);
+	if (newPtr)
+	{
+		memcpy(newPtr, ptr, (oldSize < newSize) ? oldSize : newSize);
+	}
+	return newPtr;
+}
+
+/* Releases all the allocations of the arena at once. The blocks are kept for the next allocations. */
+void arenaReset(memoryArena *arena)
+{
+	arena->current = NULL;
+}
+
+/* Frees all the blocks of the arena. */
+void arenaFree(memoryArena *arena)
+{
+	while (arena->first)
+	{
+		arenaBlock *next = arena->first->next;
+
+		free(arena->first);
+		arena->first = next;
+	}
+	arena->current = NULL;
+}
+
+/* Makes sure there is a place for one more item in a malloc array of 'itemSize' sized items. */
+/* Doubles the array size if it's full. Returns if it succeeded. */
+bool growArray(void **arr, int *arrSize, int itemsNum, size_t itemSize)
+{
+	void *newArr;
+	int newSize;
+
+	if (itemsNum < *arrSize)
+	{
+		return TRUE;
+	}
+
+	newSize = *arrSize ? *arrSize * 2 : FIRST_ARRAY_SIZE;
+	newArr = realloc(*arr, newSize * itemSize);
+	if (!newArr)
+	{
+		return FALSE;
+	}
+
+	*arr = newArr;
+	*arrSize = newSize;
+	return TRUE;
+}
+
+/* Adds an uninitialized line to the end of the list, and returns a pointer to it (or NULL if there is no memory). */
+/* The lines are kept in LINES_CHUNK_SIZE chunks from the arena, so a line never moves while the list grows. */
+lineInfo *addLine(memoryArena *arena, linesList *lines)
+{
+	int chunkInd = lines->linesNum / LINES_CHUNK_SIZE;
+
+	/* Add a new chunk when the last one is full */
+	if (lines->linesNum % LINES_CHUNK_SIZE == 0)
+	{
+		lineInfo *chunk;
+
+		/* Grow the chunks array */
+		if (chunkInd == lines->chunksArrSize)
+		{
+			int newSize = lines->chunksArrSize ? lines->chunksArrSize * 2 : FIRST_ARRAY_SIZE;
+			lineInfo **newChunksArr = (lineInfo **)arenaGrow(arena, lines->chunksArr,
+				lines->chunksArrSize * sizeof(lineInfo *), newSize * sizeof(lineInfo *));
+
+			if (!newChunksArr)
+			{
+				return NULL;
+			}
+			lines->chunksArr = newChunksArr;
+			lines->chunksArrSize = newSize;
+		}
+
+		chunk = (lineInfo *)arenaAlloc(arena, LINES_CHUNK_SIZE * sizeof(lineInfo));
+		if (!chunk)
+		{
+			return NULL;
+		}
+		lines->chunksArr[chunkInd] = chunk;
+	}
+
+	return &lines->chunksArr[chunkInd][lines->linesNum++ % LINES_CHUNK_SIZE];
+}
+
+/* Adds the lines of 'other' to the end of the list, without copying them (the list shares the chunks of 'other'). */
+/* The list must have only full chunks. Returns "FALSE" if there is no memory. */
+bool joinLines(memoryArena *arena, linesList *lines, linesList *other)
+{
+	int chunksNum = lines->linesNum / LINES_CHUNK_SIZE, otherChunksNum = (other->linesNum + LINES_CHUNK_SIZE - 1) / LINES_CHUNK_SIZE;
+	int newSize = lines->chunksArrSize ? lines->chunksArrSize : FIRST_ARRAY_SIZE;
+	lineInfo **newChunksArr;
+
+	/* Grow the chunks array */
+	while (newSize < chunksNum + otherChunksNum)
+	{
+		newSize *= 2;
+	}
+	if (newSize != lines->chunksArrSize)
+	{
+		newChunksArr = (lineInfo **)arenaGrow(arena, lines->chunksArr,
+			lines->chunksArrSize * sizeof(lineInfo *), newSize * sizeof(lineInfo *));
+		if (!newChunksArr)
+		{
+			return FALSE;
+		}
+		lines->chunksArr = newChunksArr;
+		lines->chunksArrSize = newSize;
+	}
+
+	memcpy(lines->chunksArr + chunksNum, other->chunksArr, otherChunksNum * sizeof(lineInfo *));
+	lines->linesNum += other->linesNum;
+	return TRUE;
+}
+
+/* Returns a pointer to the line with the index 'lineInd' (0 is the first line) in the list. */
+lineInfo *getLine(linesList *lines, int lineInd)
+{
+	return &lines->chunksArr[lineInd / LINES_CHUNK_SIZE][lineInd % LINES_CHUNK_SIZE];
+}
+
+/* Returns if 'wordsNum' memory words are below the memory limit of the context (the address width rule). */
+/* A limit of 0 means there is no limit. */
+bool isBelowMemoryLimit(assemblyContext *ctx, int wordsNum)
+{
+	return (ctx->options.maxWords == 0 || wordsNum < ctx->options.maxWords) ? TRUE : FALSE;
+}
+
+/* Appends 'len' bytes of str to the output (in the arena). Sets output->failed if there isn't enough memory. */
+void appendOutput(memoryArena *arena, outputBuffer *output, const char *str, size_t len)
+{
+	if (output->failed)
+	{
+		return;
+	}
+
+	/* Grow the buffer (twice the needed size, so most appends are only a copy) */
+	if (output->size + len > output->capacity)
+	{
+		size_t newCapacity = (output->size + len) * 2;
+		char *newData = (char *)arenaGrow(arena, output->data, output->capacity, newCapacity);
+
+		if (!newData)
+		{
+			output->failed = TRUE;
+			return;
+		}
+		output->data = newData;
+		output->capacity = newCapacity;
+	}
+
+	memcpy(output->data + output->size, str, len);
+	output->size += len;
+}
+
+/* Appends a string to the output. */
+void appendOutputStr(memoryArena *arena, outputBuffer *output, const char *str)
+{
+	appendOutput(arena, output, str, strlen(str));
+}
+
+/* Appends a number (in decimal) to the output. */
+void appendOutputNum(memoryArena *arena, outputBuffer *output, int num)
+{
+	char numStr[3 * sizeof(int) + 2];
+
+	appendOutput(arena, output, numStr, sprintf(numStr, "%d", num));
+}
+
+/* Appends an unsigned number to the output in 'bytesNum' bytes, little endian (the byte order of the binary files). */
+void appendOutputUint(memoryArena *arena, outputBuffer *output, unsigned long num, int bytesNum)
+{
+	char bytes[sizeof(unsigned long)];
+	int i;
+
+	for (i = 0; i < bytesNum; i++)
+	{
+		bytes[i] = (char)(num & 0xFF);
+		num >>= BYTE_SIZE;
+	}
+
+	appendOutput(arena, output, bytes, bytesNum);
+}
+
+/*Returns a pointer to the macro with 'macroName' name in ctx->macroArr or NULL if there isn't such macro. */
+macro *getMacro(assemblyContext *ctx, char *macroName)
+{
+	unsigned int hash, mask = ctx->macroIndex.size - 1, i;
+
+	ctx->stats.lookupsNum++;
+
+	/* Fast path - there aren't any macros (and the lookup doesn't have to be kept) */
+	if (!macroName || (!ctx->macroIndex.count && !ctx->keepLookups))
+	{
+		return NULL;
+	}
+
+	hash = getNameHash(macroName);
+	if (ctx->keepLookups)
+	{
+		keepLookup(ctx, hash, LOOKUP_MACRO);
+	}
+	if (!ctx->macroIndex.count)
+	{
+		return NULL;
+	}
+	for (i = hash & mask; ctx->macroIndex.slots[i].hash; i = (i + 1) & mask)
+	{
+		if (ctx->macroIndex.slots[i].hash == hash && strcmp(macroName, ctx->macroArr[ctx->macroIndex.slots[i].index].name) == 0)
+		{
+			return &ctx->macroArr[ctx->macroIndex.slots[i].index];
+		}
+	}
+	return NULL;
+}
+/* Returns a pointer to the label with 'labelName' name in ctx->labelArr or NULL if there isn't such label. */
+labelInfo *getLabel(assemblyContext *ctx, char *labelName)
+{
+	unsigned int hash, mask = ctx->labelIndex.size - 1, i;
+
+	ctx->stats.lookupsNum++;
+
+	/* Fast path - there aren't any labels (and the lookup doesn't have to be kept) */
+	if (!labelName || (!ctx->labelIndex.count && !ctx->keepLookups))
+	{
+		return NULL;
+	}
+
+	hash = getNameHash(labelName);
+	if (ctx->keepLookups)
+	{
+		keepLookup(ctx, hash, LOOKUP_LABEL);
+	}
+	if (!ctx->labelIndex.count)
+	{
+		return NULL;
+	}
+	for (i = hash & mask; ctx->labelIndex.slots[i].hash; i = (i + 1) & mask)
+	{
+		if (ctx->labelIndex.slots[i].hash == hash && strcmp(labelName, ctx->labelArr[ctx->labelIndex.slots[i].index].name) == 0)
+		{
+			return &ctx->labelArr[ctx->labelIndex.slots[i].index];
+		}
+	}
+	return NULL;
+}
+
+/* Returns the macro value and save the value inside 'val' */
+int *getMacroValue(macro *mac,int *val)
+{
+	val = &(mac->value);
+		return val;
+}
+/* Returns the address of the 'operand'  */
+int getAddressValue(operandInfo *operand)
+{
+	int add = operand->address;
+		return add;
+}
+/* Return the value inside the Index 'operand' */
+int getIndexValue(operandInfo *operand)
+{
+	int val = operand->indexVal;
+		return val;
+}
+
+/* Returns the reserved word (command, directive, register or macro command) 'str' is, or NULL if it isn't one. */
+/* g_reservedHash is a perfect hash (generated by genReserved), so it's a single probe and strcmp. */
+const reservedWord *getReservedWord(const char *str)
+{
+	const reservedWord *word;
+	unsigned int hash = 0;
+	int length;
+
+	for (length = 0; str[length]; length++)
+	{
+		/* Longer than all the reserved words */
+		if (length == RESERVED_MAX_LENGTH)
+		{
+			return NULL;
+		}
+		hash = RESERVED_HASH_STEP(hash, str[length], RESERVED_HASH_MULT);
+	}
+
+	word = &g_reservedHash[(hash >> RESERVED_HASH_SHIFT) & (RESERVED_HASH_SIZE - 1)];
+	if (word->name && strcmp(str, word->name) == 0)
+	{
+		return word;
+	}
+	return NULL;
+}
+
+/* Returns the ID of the command with 'cmdName' name in g_cmdArr or -1 if there isn't such command. */
+int getCmdId(char *cmdName)
+{
+	const reservedWord *word = getReservedWord(cmdName);
+
+	if (word && word->kind == RESERVED_COMMAND)
+	{
+		/* The commands in g_cmdArr are in opcode order */
+		return word->id;
+	}
+	return -1;
+}
+
+/* Returns a pointer to the start of first token. */
+/* Also makes *endOfTok (if it's not NULL) to point at the last char after the token. */
+char *getFirstTok(char *str, char **endOfTok)
+{
+	char *tokStart = str;
+	char *tokEnd = NULL;
+
+	/* Trim the start */
+	trimLeftStr(&tokStart);
+
+	/* Find the end of the first word */
+	tokEnd = tokStart;
+	while (*tokEnd != '\0' && !IS_SPACE_CHAR(*tokEnd))
+	{
+		tokEnd++;
+	}
+
+	/* Add \0 at the end if needed */
+	if (*tokEnd != '\0')
+	{
+		*tokEnd = '\0';
+		tokEnd++;
+	}
+
+	/* Make *endOfTok (if it's not NULL) to point at the last char after the token */
+	if (endOfTok)
+	{
+		*endOfTok = tokEnd;
+	}
+	return tokStart;
+}
+/* Removes spaces from start */
+void trimLeftStr(char **ptStr)
+{
+	/* Return if it's NULL */
+	if (!ptStr)
+	{
+		return;
+	}
+
+	/* Get ptStr to the start of the actual text */
+	while (IS_SPACE_CHAR(**ptStr))
+	{
+		++*ptStr;
+	}
+}
+/* Returns a pointer to the start of the first operand in 'line' and change the end of it to '\0'. */
+/* Also makes *endOfOp (if it's not NULL) point at the next char after the operand. */
+char *getFirstOperand(assemblyContext *ctx, char *line, char **endOfOp, bool *foundComma)
+{
+	if (!isWhiteSpaces(line))
+	{
+		/* Find the first comma */
+		char *end = findLineChar(&ctx->scan, line, ',');
+		if (end)
+		{
+			*foundComma = TRUE;
+			*end = '\0';
+			end++;
+		}
+		else
+		{
+			*foundComma = FALSE;
+		}
+
+		/* Set endOfOp (if it's not NULL) to point at the next char after the operand
+		(Or at the end of it if it's the end of the line) */
+		if (endOfOp)
+		{
+			if (end)
+			{
+				*endOfOp = end;
+			}
+			else
+			{
+				*endOfOp = strchr(line, '\0');
+			}
+		}
+	}
+
+	trimStr(&line);
+	return line;
+}
+
+/* Removes all the spaces from the edges of the string ptStr is pointing to. */
+void trimStr(char **ptStr)
+{
+	char *eos;
+
+	/* Return if it's NULL or empty string */
+	if (!ptStr || **ptStr == '\0')
+	{
+		return;
+	}
+
+	trimLeftStr(ptStr);
+
+	/* oes is pointing to the last char in str, before '\0' */
+	eos = *ptStr + strlen(*ptStr) - 1;
+
+	/* Remove spces from the end */
+	while (IS_SPACE_CHAR(*eos) && eos != *ptStr)
+	{
+		*eos-- = '\0';
+	}
+}
+
+/* Returns if str contains only one word. */
+bool isOneWord(char *str)
+{
+	trimLeftStr(&str);							/* Skip the spaces at the start */
+	while (!IS_SPACE_CHAR(*str) && *str) { str++; }	/* Skip the text at the middle */					
+
+	/* Return if it's the end of the text or not. */
+	return isWhiteSpaces(str);
+}
+
+/* Returns if str contains only white spaces. */
+bool isWhiteSpaces(char *str)
+{
+	while (*str)
+	{
+		if (!IS_SPACE_CHAR(*str++))
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/* Returns if labelStr is a legal label name. */
+bool isLegalLabel(assemblyContext *ctx, char *labelStr, int lineNum, bool printErrors)
+{
+	int labelLength = strlen(labelStr), i;
+	const reservedWord *word;
+
+	/* Check if the label is short enough */
+	if (strlen(labelStr) > MAX_LABEL_LENGTH)
+	{
+		if (printErrors) printError(ctx, lineNum, "Label is too long. Max label name length is %d.", MAX_LABEL_LENGTH);
+		return FALSE;
+	}
+
+	/* Check if the label isn't an empty string */
+	if (*labelStr == '\0')
+	{
+		if (printErrors) printError(ctx, lineNum, "Label name is empty.");
+		return FALSE;
+	}
+
+	/* Check if the 1st char is a letter. */
+	if (IS_SPACE_CHAR(*labelStr))
+	{
+		if (printErrors) printError(ctx, lineNum, "Label must start at the start of the line.");
+		return FALSE;
+	}
+
+	/* Check if it's chars only. */
+	for (i = 1; i < labelLength; i++)
+	{
+		if (!isalnum(labelStr[i]))
+		{
+			if (printErrors) printError(ctx, lineNum, "\"%s\" is illegal label - use letters and numbers only.", labelStr);
+			return FALSE;
+		}
+	}
+
+	/* Check if the 1st char is a letter. */
+	if (!isalpha(*labelStr))
+	{
+		if (printErrors) printError(ctx, lineNum, "\"%s\" is illegal label - first char must be a letter.", labelStr);
+		return FALSE;
+	}
+
+	/* Check if it's not a name of a register or a command */
+	word = getReservedWord(labelStr);
+	if (word && word->kind == RESERVED_REGISTER)
+	{
+		if (printErrors) printError(ctx, lineNum, "\"%s\" is illegal label - don't use a name of a register.", labelStr);
+		return FALSE;
+	}
+
+	if (word && word->kind == RESERVED_COMMAND)
+	{
+		if (printErrors) printError(ctx, lineNum, "\"%s\" is illegal label - don't use a name of a command.", labelStr);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Returns if the label exists. */
+bool isExistingLabel(assemblyContext *ctx, char *label)
+{
+	if (getLabel(ctx, label))
+	{
+		return TRUE;
+	}
+
+	return FALSE;
+}
+bool isExistingMacro(assemblyContext *ctx, char *macro)
+{
+	if(getMacro(ctx, macro))
+		return TRUE;
+return FALSE;
+
+}
+/* Returns if the label is already in the entry lines array. */
+bool isExistingEntryLabel(assemblyContext *ctx, char *labelName)
+{
+	unsigned int hash, mask = ctx->entryIndex.size - 1, i;
+
+	if (!labelName || (!ctx->entryIndex.count && !ctx->keepLookups))
+	{
+		return FALSE;
+	}
+
+	hash = getNameHash(labelName);
+	if (ctx->keepLookups)
+	{
+		keepLookup(ctx, hash, LOOKUP_ENTRY);
+	}
+	if (!ctx->entryIndex.count)
+	{
+		return FALSE;
+	}
+	for (i = hash & mask; ctx->entryIndex.slots[i].hash; i = (i + 1) & mask)
+	{
+		if (ctx->entryIndex.slots[i].hash == hash && strcmp(labelName, ctx->entryArr[ctx->entryIndex.slots[i].index].name) == 0)
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* Returns if str is a register name, and update value to be the register value. */
+bool isRegister(char *str, int *value)
+{
+	const reservedWord *word = getReservedWord(str);
+
+	if (word && word->kind == RESERVED_REGISTER) 
+	{
+		/* Update value if it's not NULL */
+		if (value)
+		{
+			*value = word->id;
+		}
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Return a bool, represent whether 'line' is a comment or not. */
+/* If the first char is ';' but it's not at the start of the line, it returns true and update line->isError to be TRUE. */
+bool isCommentOrEmpty(assemblyContext *ctx, lineInfo *line)
+{
+	char *startOfText = line->lineStr; /* We don't want to change line->lineStr */
+
+	if (*line->lineStr == ';')
+	{
+		/* Comment */
+		return TRUE;
+	}
+
+	trimLeftStr(&startOfText);
+	if (*startOfText == '\0')
+	{
+		/* Empty line */
+		return TRUE;
+	}
+	if (*startOfText == ';')
+	{
+		/* Illegal comment - ';' isn't at the start of the line */
+		printError(ctx, line->lineNum, "Comments must start with ';' at the start of the line.");
+		line->isError = TRUE;
+		return TRUE;
+	}
+
+	/* Not empty or comment */
+	return FALSE;
+}
+
+
+/* Returns if the cmd is a directive. */
+bool isDirective(char *cmd)
+{
+	return ((*cmd == '.') && ( *(cmd+1) == 'd' || *(cmd+1)=='s' || *(cmd+1) == 'e' || *(cmd+1) == 'i' ) && (*(cmd+2) != 'e')) ? TRUE : FALSE;
+}
+/* Returns 'true' if the line is a MACRO. */
+bool isMacro(char *cmd)
+{
+	return ((*cmd == '.') && (*(cmd+1) == 'd') && (*(cmd+2) == 'e')) ? TRUE : FALSE; 
+}
+
+
+/* Returns if the strParam is a legal string param (enclosed in quotes), and remove the quotes. */
+bool isLegalStringParam(assemblyContext *ctx, char **strParam, int lineNum)
+{
+	/* check if the string param is enclosed in quotes */
+	if ((*strParam)[0] == '"' && (*strParam)[strlen(*strParam) - 1] == '"')
+	{
+		/* remove the quotes */
+		(*strParam)[strlen(*strParam) - 1] = '\0';
+		++*strParam;
+		return TRUE;
+	}
+
+	if (**strParam == '\0')
+	{
+		printError(ctx, lineNum, "No parameter.");
+	}
+	else
+	{
+		printError(ctx, lineNum, "The parameter for .string must be enclosed in quotes.");
+	}
+	return FALSE;
+}
+
+
+/* Returns if the num is a legal number param, and save it's value in *value. */
+bool isLegalNum(assemblyContext *ctx, char *numStr, int numOfBits, int lineNum, int *value)
+{
+	char *endOfNum;
+	/* maxNum is the max number you can represent with (MAX_LABEL_LENGTH - 1) bits 
+	 (-1 for the negative/positive bit) */
+	int maxNum = (1 << numOfBits) - 1;
+
+	if (isWhiteSpaces(numStr))
+	{
+		printError(ctx, lineNum, "Empty parameter.");
+		return FALSE;
+	}
+
+	*value = strtol(numStr, &endOfNum, 0);
+
+	/* Check if endOfNum is at the end of the string */
+	if (*endOfNum)
+	{
+		printError(ctx, lineNum, "\"%s\" isn't a valid number.", numStr);
+		return FALSE;
+	}
+
+	/* Check if the number is small enough to fit into 1 memory word 
+	(if the absolute value of number is smaller than 'maxNum' */
+	if (*value > maxNum || *value < -maxNum)
+	{
+		printError(ctx, lineNum, "\"%s\" is too %s, must be between %d and %d.", numStr, (*value > 0) ? "big" : "small", -maxNum, maxNum);
+		return FALSE;
+	}
+
+	return TRUE;
+}